@@ -8,7 +8,7 @@
 #include "MaterialExpressionWorldToUV.generated.h"
 
 /**
- * 
+ * Hexagon local UVs computed per pixel from the world location, the terrain material textures chunk meshes through it.
  */
 UCLASS()
 class UNNAMEDFACTORYGAME_API UMaterialExpressionWorldToUV : public UMaterialExpression
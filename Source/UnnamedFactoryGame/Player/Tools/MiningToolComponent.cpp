@@ -3,6 +3,7 @@
 #include "MiningToolComponent.h"
 
 #include "UnnamedFactoryGame/World/Generation/ProceduralHexagonMeshComponent.h"
+#include "UnnamedFactoryGame/World/Generation/WorldGenerationSubSystem.h"
 
 UMiningToolComponent::UMiningToolComponent()
 {
@@ -20,19 +21,19 @@ void UMiningToolComponent::TickComponent( const float DeltaTime, const ELevelTic
 	if( !IsValid( MeshComponent ) )
 		return;
 
-	const FIntVector Coordinate = FHexagonVoxel::WorldToVoxel( InteractableData.ImpactPoint - InteractableData.ImpactNormal * 10 );
-	MeshComponent->SetWorldLocation( FHexagonVoxel( Coordinate ).WorldLocation );
+	const FVoxelView Voxel = UWorldGenerationSubSystem::Get( this )->GetVoxelView( InteractableData.ImpactPoint - InteractableData.ImpactNormal * 10 );
+	MeshComponent->SetVisibility( Voxel.IsSolid() );
+	MeshComponent->SetWorldLocation( Voxel.GetWorldLocation() );
 }
 
 void UMiningToolComponent::UpdateSize( const int32 SizeChange )
 {
 	Radius = FMath::Clamp( Radius + SizeChange, MinRadius, MaxRadius );
 
-	TMap< FIntVector, FHexagonVoxel > HexagonVoxels;
+	FChunkVoxels HexagonVoxels( FIntVector( -Radius ), FIntVector( Radius * 2 + 1 ) );
 
-	FIntVector    VoxelCoordinate = FIntVector::ZeroValue;
-	FHexagonVoxel Voxel( VoxelCoordinate, EVoxelType::Ground );
-	HexagonVoxels.Add( VoxelCoordinate, Voxel );
+	FIntVector VoxelCoordinate = FIntVector::ZeroValue;
+	HexagonVoxels.SetType( VoxelCoordinate, EVoxelType::Ground );
 
 	TQueue< TTuple< int32, FIntVector > > Queue;
 	Queue.Enqueue( MakeTuple( 1, VoxelCoordinate ) );
@@ -43,19 +44,20 @@ void UMiningToolComponent::UpdateSize( const int32 SizeChange )
 		for( const FIntVector& Direction: HexagonDirections )
 		{
 			VoxelCoordinate = Current.Value + Direction;
-			Voxel           = FHexagonVoxel( VoxelCoordinate, EVoxelType::Ground );
+			if( HexagonVoxels.GetType( VoxelCoordinate ) != EVoxelType::Air )
+				continue;
 
 			if( Current.Key < Radius )
 			{
-				HexagonVoxels.Add( VoxelCoordinate, Voxel );
+				HexagonVoxels.SetType( VoxelCoordinate, EVoxelType::Ground );
 				Queue.Enqueue( MakeTuple( Current.Key + 1, VoxelCoordinate ) );
 			}
 			else if( Current.Key == Radius && Direction.Z == 0 )
-				HexagonVoxels.Add( VoxelCoordinate, Voxel );
+				HexagonVoxels.SetType( VoxelCoordinate, EVoxelType::Ground );
 		}
 	}
 
-	MeshComponent->Generate( HexagonVoxels );
+	MeshComponent->Generate< FPreviewMeshPolicy >( HexagonVoxels );
 }
 
 void UMiningToolComponent::Activate( const bool bReset )
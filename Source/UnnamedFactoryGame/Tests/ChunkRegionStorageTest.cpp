@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "UnnamedFactoryGame/World/Generation/ChunkRegionStorage.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FChunkVoxels MakeChunk( const FIntPoint& ChunkCoordinate, const int32 SolidHeight, const EVoxelType Type )
+	{
+		constexpr int32 ChunkSize = 8;
+
+		FChunkVoxels Voxels( FIntVector( ChunkCoordinate.X * ChunkSize, ChunkCoordinate.Y * ChunkSize, 0 ), FIntVector( ChunkSize, ChunkSize, 16 ) );
+		for( int32 Q = 0; Q < ChunkSize; ++Q )
+		{
+			for( int32 R = 0; R < ChunkSize; ++R )
+				Voxels.SetColumn( Voxels.GetOrigin().X + Q, Voxels.GetOrigin().Y + R, SolidHeight, Type );
+		}
+
+		return Voxels;
+	}
+
+	/** Loads through the pipe and pumps the game thread until the result arrives */
+	TOptional< FChunkVoxels > LoadChunk( FChunkRegionStorage& Storage, const FIntPoint& ChunkCoordinate )
+	{
+		bool                      IsLoaded = false;
+		TOptional< FChunkVoxels > Result;
+		Storage.LoadChunk( ChunkCoordinate,
+		                   [ &IsLoaded, &Result ]( TOptional< FChunkVoxels >&& Voxels )
+		                   {
+							   Result   = MoveTemp( Voxels );
+							   IsLoaded = true;
+						   } );
+
+		Storage.Flush();
+		while( !IsLoaded )
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle( ENamedThreads::GameThread );
+
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FChunkRegionStorageTest,
+                                  "UnnamedFactoryGame.Storage.RegionFiles",
+                                  EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter )
+
+bool FChunkRegionStorageTest::RunTest( const FString& Parameters )
+{
+	const FString Directory = FPaths::Combine( FPaths::ProjectIntermediateDir(), TEXT( "ChunkRegionStorageTest" ) );
+	const FString Filename  = FPaths::Combine( Directory, TEXT( "Region_0_0.bin" ) );
+	IFileManager::Get().DeleteDirectory( *Directory, false, true );
+
+	const FIntPoint First( 0, 0 );
+	const FIntPoint Second( 1, 0 );
+
+	{
+		FChunkRegionStorage Storage( Directory );
+		Storage.SaveChunk( First, MakeChunk( First, 4, EVoxelType::Stone ) );
+		Storage.SaveChunk( Second, MakeChunk( Second, 6, EVoxelType::Ground ) );
+		Storage.Flush();
+
+		const int64 InitialSize = IFileManager::Get().FileSize( *Filename );
+		TestTrue( TEXT( "Region written" ), InitialSize > 0 );
+
+		// Saves append, compaction has to keep the stale copies from piling up
+		for( int32 i = 0; i < 32; ++i )
+			Storage.SaveChunk( First, MakeChunk( First, 4 + i % 4, EVoxelType::Stone ) );
+
+		Storage.Flush();
+		TestTrue( TEXT( "Region compacted" ), IFileManager::Get().FileSize( *Filename ) <= InitialSize * 2 );
+
+		const TOptional< FChunkVoxels > FirstVoxels = LoadChunk( Storage, First );
+		if( TestTrue( TEXT( "First loaded" ), FirstVoxels.IsSet() ) )
+		{
+			TestEqual( TEXT( "Last save of first" ), FirstVoxels->GetType( FIntVector( 0, 0, 6 ) ), EVoxelType::Stone );
+			TestEqual( TEXT( "Last save of first top" ), FirstVoxels->GetType( FIntVector( 0, 0, 7 ) ), EVoxelType::Air );
+		}
+
+		const TOptional< FChunkVoxels > SecondVoxels = LoadChunk( Storage, Second );
+		if( TestTrue( TEXT( "Second loaded" ), SecondVoxels.IsSet() ) )
+			TestEqual( TEXT( "Second untouched" ), SecondVoxels->GetType( FIntVector( 8, 0, 5 ) ), EVoxelType::Ground );
+
+		TestFalse( TEXT( "Unsaved chunk" ), LoadChunk( Storage, FIntPoint( 0, 1 ) ).IsSet() );
+	}
+
+	// The first slot claims more data than the file holds
+	{
+		TUniquePtr< IFileHandle > File( FPlatformFileManager::Get().GetPlatformFile().OpenWrite( *Filename, true, true ) );
+		const int32               Entry[ 2 ] = { 16, MAX_int32 - 16 };
+		TestTrue( TEXT( "Header corrupted" ), File && File->Seek( sizeof( uint32 ) * 2 ) && File->Write( reinterpret_cast< const uint8* >( Entry ), sizeof( Entry ) ) );
+	}
+
+	{
+		FChunkRegionStorage Storage( Directory );
+		TestFalse( TEXT( "Corrupt entry rejected" ), LoadChunk( Storage, First ).IsSet() );
+		TestTrue( TEXT( "Other chunk still readable" ), LoadChunk( Storage, Second ).IsSet() );
+	}
+
+	IFileManager::Get().DeleteDirectory( *Directory, false, true );
+	return true;
+}
+
+#endif
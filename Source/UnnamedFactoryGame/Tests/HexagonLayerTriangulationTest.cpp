@@ -0,0 +1,149 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexagonMeshTestUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "UnnamedFactoryGame/World/Generation/ProceduralHexagonMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Positions of separately built faces differ in the last bits, so edges are matched on a 0.01 unit grid */
+	FIntVector Quantize( const FVector3f& Location )
+	{
+		return FIntVector( FMath::RoundToInt32( Location.X * 100 ), FMath::RoundToInt32( Location.Y * 100 ), FMath::RoundToInt32( Location.Z * 100 ) );
+	}
+
+	/** Number of edges not shared by exactly two triangles, a closed mesh without T-junctions has none */
+	int32 CountOpenEdges( const FHexagonMeshData& MeshData )
+	{
+		TMap< TPair< FIntVector, FIntVector >, int32 > EdgeUses;
+		for( int32 i = 0; i < MeshData.Triangles.Num(); i += 3 )
+		{
+			for( int32 Corner = 0; Corner < 3; ++Corner )
+			{
+				const FIntVector A = Quantize( MeshData.Vertices[ MeshData.Triangles[ i + Corner ] ] );
+				const FIntVector B = Quantize( MeshData.Vertices[ MeshData.Triangles[ i + ( Corner + 1 ) % 3 ] ] );
+
+				const bool IsOrdered = A.X < B.X || ( A.X == B.X && ( A.Y < B.Y || ( A.Y == B.Y && A.Z < B.Z ) ) );
+				++EdgeUses.FindOrAdd( IsOrdered ? MakeTuple( A, B ) : MakeTuple( B, A ) );
+			}
+		}
+
+		int32 NumOpen = 0;
+		for( const TPair< TPair< FIntVector, FIntVector >, int32 >& Edge: EdgeUses )
+			NumOpen += Edge.Value != 2;
+
+		return NumOpen;
+	}
+
+	/** Area of the triangles facing up, OutNumClockwise counts the ones wound clockwise seen from above */
+	double GetTopArea( const FHexagonMeshData& MeshData, int32& OutNumTriangles, int32& OutNumClockwise )
+	{
+		double Area     = 0;
+		OutNumTriangles = 0;
+		OutNumClockwise = 0;
+		for( int32 i = 0; i < MeshData.Triangles.Num(); i += 3 )
+		{
+			const FVector3f& A = MeshData.Vertices[ MeshData.Triangles[ i ] ];
+			const FVector3f& B = MeshData.Vertices[ MeshData.Triangles[ i + 1 ] ];
+			const FVector3f& C = MeshData.Vertices[ MeshData.Triangles[ i + 2 ] ];
+			if( MeshData.Normals[ MeshData.Triangles[ i ] ].ToFVector3f().Z < .5f )
+				continue;
+
+			const FVector3f Normal = FVector3f::CrossProduct( B - A, C - A );
+			OutNumTriangles        += 1;
+			OutNumClockwise        += Normal.Z < 0;
+			Area                   += FMath::Abs( Normal.Z ) / 2;
+		}
+
+		return Area;
+	}
+
+	int32 CountTopFaces( const FChunkVoxels& Voxels )
+	{
+		int32 NumFaces = 0;
+		Voxels.ForEachColumn(
+			[ &NumFaces ]( const FIntPoint&, const TConstArrayView< FVoxelSpan > Column ) { NumFaces += Column.Num(); } );
+
+		return NumFaces;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FHexagonLayerTriangulationTest,
+                                  "UnnamedFactoryGame.Meshing.LayerTriangulation",
+                                  EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter )
+
+bool FHexagonLayerTriangulationTest::RunTest( const FString& Parameters )
+{
+	const double HexagonArea = 3 * Root3Divided2 * HexagonRadius * HexagonRadius;
+
+	// Single layers from solid to barely connected, and a few layers deep so holes stack into pits and overhangs
+	const struct
+	{
+		int32 Height;
+		int32 Depth;
+		float HoleFraction;
+	} Cases[] = { { 1, 1, 0 }, { 1, 1, .2f }, { 1, 1, .5f }, { 1, 1, .8f }, { 4, 3, .5f } };
+
+	constexpr int32 NumCases = UE_ARRAY_COUNT( Cases );
+	for( int32 Seed = 0; Seed < NumCases * 4; ++Seed )
+	{
+		const auto&        Case   = Cases[ Seed % NumCases ];
+		const FChunkVoxels Voxels = HexagonMeshTest::MakeVoxels( 24, Case.Height, Case.Depth, Case.HoleFraction, Seed );
+		const FString      Name   = FString::Printf( TEXT( "Height %d, %.0f%% holes, seed %d" ), Case.Height, Case.HoleFraction * 100, Seed );
+
+		const FHexagonMeshData MeshData = UProceduralHexagonMeshComponent::BuildMesh< FPreviewMeshPolicy >( Voxels );
+
+		TestEqual( Name + TEXT( ": open edges" ), CountOpenEdges( MeshData ), 0 );
+
+		// Merged top faces cover exactly the hexagons they replace, all wound the same way
+		int32        NumTopTriangles, NumClockwise;
+		const double TopArea = GetTopArea( MeshData, NumTopTriangles, NumClockwise );
+		TestEqual( Name + TEXT( ": top area" ), TopArea, CountTopFaces( Voxels ) * HexagonArea, HexagonArea / 100 );
+		TestTrue( Name + TEXT( ": consistent top winding" ), NumClockwise == 0 || NumClockwise == NumTopTriangles );
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FHexagonLayerTriangulationBenchmark,
+                                  "UnnamedFactoryGame.Meshing.LayerTriangulationBenchmark",
+                                  EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter )
+
+bool FHexagonLayerTriangulationBenchmark::RunTest( const FString& Parameters )
+{
+	// Heavily mined single layers, the time per hexagon should stay flat as the layer grows
+	for( const int32 Size: { 16, 32, 64, 128 } )
+	{
+		for( const float HoleFraction: { .1f, .5f } )
+		{
+			const FChunkVoxels Voxels = HexagonMeshTest::MakeVoxels( Size, 1, 1, HoleFraction, Size );
+
+			FHexagonMeshData MeshData;
+			UProceduralHexagonMeshComponent::BuildMesh< FPreviewMeshPolicy >( Voxels, MeshData );
+
+			constexpr int32 NumIterations = 20;
+
+			const double StartTime = FPlatformTime::Seconds();
+			for( int32 i = 0; i < NumIterations; ++i )
+			{
+				MeshData.Reset();
+				UProceduralHexagonMeshComponent::BuildMesh< FPreviewMeshPolicy >( Voxels, MeshData );
+			}
+
+			const double Time = ( FPlatformTime::Seconds() - StartTime ) / NumIterations;
+			AddInfo( FString::Printf( TEXT( "%3dx%-3d %2.0f%% holes: %8.3f ms, %6.1f ns per hexagon, %d triangles" ),
+			                          Size,
+			                          Size,
+			                          HoleFraction * 100,
+			                          Time * 1000,
+			                          Time * 1e9 / ( Size * Size ),
+			                          MeshData.Triangles.Num() / 3 ) );
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexagonMeshTestUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "UnnamedFactoryGame/World/Generation/ProceduralHexagonMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Builds the mesh twice into the same output, the first build grows the thread's scratch buffers and the output so the second may only reuse them */
+	template< typename PolicyType >
+	int32 CountSteadyStateAllocations( const FChunkVoxels& Voxels, const int32 Bottom, const int32 Top, FHexagonMeshData& OutMeshData )
+	{
+		UProceduralHexagonMeshComponent::BuildMesh< PolicyType >( Voxels, OutMeshData, Bottom, Top );
+		OutMeshData.Reset();
+
+		HexagonMeshTest::FScopedAllocationCounter Counter;
+		UProceduralHexagonMeshComponent::BuildMesh< PolicyType >( Voxels, OutMeshData, Bottom, Top );
+		return Counter.GetNum();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FHexagonMeshAllocationTest,
+                                  "UnnamedFactoryGame.Meshing.SteadyStateAllocations",
+                                  EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter )
+
+bool FHexagonMeshAllocationTest::RunTest( const FString& Parameters )
+{
+	const FChunkVoxels Terrain = HexagonMeshTest::MakeVoxels( 18, 24, 6, .3f, 1 );
+	const FChunkVoxels Flat    = HexagonMeshTest::MakeVoxels( 18, 24, 0, 0, 2 );
+
+	FHexagonMeshData MeshData;
+
+	TestEqual( TEXT( "Chunk" ), CountSteadyStateAllocations< FChunkMeshPolicy >( Terrain, 0, MAX_int32, MeshData ), 0 );
+	TestFalse( TEXT( "Chunk mesh" ), MeshData.IsEmpty() );
+
+	TestEqual( TEXT( "Chunk section" ), CountSteadyStateAllocations< FChunkMeshPolicy >( Terrain, 16, 24, MeshData ), 0 );
+	TestFalse( TEXT( "Chunk section mesh" ), MeshData.IsEmpty() );
+
+	TestEqual( TEXT( "Flat chunk" ), CountSteadyStateAllocations< FChunkMeshPolicy >( Flat, 0, MAX_int32, MeshData ), 0 );
+	TestFalse( TEXT( "Flat chunk mesh" ), MeshData.IsEmpty() );
+
+	TestEqual( TEXT( "Preview" ), CountSteadyStateAllocations< FPreviewMeshPolicy >( Terrain, 0, MAX_int32, MeshData ), 0 );
+	TestFalse( TEXT( "Preview mesh" ), MeshData.IsEmpty() );
+
+	TestEqual( TEXT( "Textured" ), CountSteadyStateAllocations< FHexagonMeshPolicy >( Terrain, 0, MAX_int32, MeshData ), 0 );
+	TestFalse( TEXT( "Textured mesh" ), MeshData.IsEmpty() );
+
+	return true;
+}
+
+#endif
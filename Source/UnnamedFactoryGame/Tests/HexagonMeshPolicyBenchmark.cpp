@@ -0,0 +1,95 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexagonMeshTestUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "UnnamedFactoryGame/World/Generation/Chunk.h"
+#include "UnnamedFactoryGame/World/Generation/ProceduralHexagonMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** The per voxel skip callback chunks were meshed with before policies, kept here only as the benchmark's baseline */
+	DECLARE_DELEGATE_RetVal_OneParam( bool, FSkipGenerationDelegate, FHexagonVoxel );
+
+	template< typename FunctionType >
+	double TimeBuilds( const int32 NumIterations, FunctionType Function )
+	{
+		Function();
+
+		const double StartTime = FPlatformTime::Seconds();
+		for( int32 i = 0; i < NumIterations; ++i )
+			Function();
+
+		return ( FPlatformTime::Seconds() - StartTime ) / NumIterations;
+	}
+
+	/** Executes Delegate for every solid voxel on a copy of it, the dispatch the delegate path paid on top of meshing */
+	int32 DispatchPerVoxel( const FChunkVoxels& Voxels, const FSkipGenerationDelegate& Delegate )
+	{
+		int32 NumSkipped = 0;
+		Voxels.ForEachVoxel(
+			[ & ]( const FIntVector& VoxelCoordinate, const EVoxelType Type )
+			{
+				FHexagonVoxel Voxel;
+				if( Type != EVoxelType::Air && Voxels.GetVoxel( VoxelCoordinate, Voxel ) )
+					NumSkipped += Delegate.Execute( Voxel );
+			} );
+
+		return NumSkipped;
+	}
+
+	/** Times PolicyType alone and with the per voxel delegate on top, the two builds emit the same mesh and differ only in how the ring is skipped */
+	template< typename PolicyType >
+	void TimePolicy( FAutomationTestBase& Test, const TCHAR* Name, const FChunkVoxels& Voxels, const FSkipGenerationDelegate& Delegate, const int32 NumIterations )
+	{
+		FHexagonMeshData MeshData;
+
+		const double PolicyTime = TimeBuilds( NumIterations,
+		                                      [ & ]
+		                                      {
+												  MeshData.Reset();
+												  UProceduralHexagonMeshComponent::BuildMesh< PolicyType >( Voxels, MeshData );
+											  } );
+
+		int32        NumSkipped   = 0;
+		const double DelegateTime = TimeBuilds( NumIterations,
+		                                        [ & ]
+		                                        {
+													MeshData.Reset();
+													UProceduralHexagonMeshComponent::BuildMesh< PolicyType >( Voxels, MeshData );
+													NumSkipped = DispatchPerVoxel( Voxels, Delegate );
+												} );
+
+		Test.TestTrue( TEXT( "Skipped border voxels" ), NumSkipped > 0 );
+		Test.AddInfo( FString::Printf( TEXT( "%-20s %8.3f ms, with per voxel delegate %8.3f ms, %.2fx" ), Name, PolicyTime * 1000, DelegateTime * 1000, DelegateTime / PolicyTime ) );
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FHexagonMeshPolicyBenchmark,
+                                  "UnnamedFactoryGame.Meshing.PolicyBenchmark",
+                                  EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter )
+
+bool FHexagonMeshPolicyBenchmark::RunTest( const FString& Parameters )
+{
+	constexpr int32 NumIterations = 20;
+
+	const int32        Size   = FChunk::GetSize();
+	const FChunkVoxels Voxels = HexagonMeshTest::MakeVoxels( Size + 2, 32, 4, .3f, 0 );
+
+	// The ring test the removed FChunk::MakeSkipGenerationDelegate bound, for the block's own chunk
+	const FSkipGenerationDelegate SkipGenerationDelegate = FSkipGenerationDelegate::CreateLambda(
+		[ Size ]( const FHexagonVoxel& Voxel )
+		{
+			const FIntVector& VoxelCoordinate = Voxel.GridLocation;
+			return VoxelCoordinate.X == 0 || VoxelCoordinate.X == Size + 1 || VoxelCoordinate.Y == 0 || VoxelCoordinate.Y == Size + 1;
+		} );
+
+	TimePolicy< FChunkMeshPolicy >( *this, TEXT( "FChunkMeshPolicy" ), Voxels, SkipGenerationDelegate, NumIterations );
+	TimePolicy< FHexagonMeshPolicy >( *this, TEXT( "FHexagonMeshPolicy" ), Voxels, SkipGenerationDelegate, NumIterations );
+	TimePolicy< FPreviewMeshPolicy >( *this, TEXT( "FPreviewMeshPolicy" ), Voxels, SkipGenerationDelegate, NumIterations );
+
+	return true;
+}
+
+#endif
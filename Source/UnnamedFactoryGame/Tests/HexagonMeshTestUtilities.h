@@ -0,0 +1,110 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "Math/RandomStream.h"
+#include "UnnamedFactoryGame/World/Generation/ChunkVoxels.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HexagonMeshTest
+{
+	/**
+	 * Counts the heap allocations the constructing thread makes while it is alive, everything is forwarded to the allocator it replaces.
+	 * Other threads keep allocating through it uncounted.
+	 */
+	class FScopedAllocationCounter : public FMalloc
+	{
+	public:
+		FScopedAllocationCounter()
+			: Inner( GMalloc )
+			, ThreadId( FPlatformTLS::GetCurrentThreadId() )
+		{
+			GMalloc = this;
+		}
+
+		virtual ~FScopedAllocationCounter() override { GMalloc = Inner; }
+
+		int32 GetNum() const { return NumAllocations; }
+
+		virtual void* Malloc( const SIZE_T Count, const uint32 Alignment ) override
+		{
+			CountAllocation();
+			return Inner->Malloc( Count, Alignment );
+		}
+
+		virtual void* TryMalloc( const SIZE_T Count, const uint32 Alignment ) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc( Count, Alignment );
+		}
+
+		virtual void* Realloc( void* Original, const SIZE_T Count, const uint32 Alignment ) override
+		{
+			if( Count > 0 )
+				CountAllocation();
+
+			return Inner->Realloc( Original, Count, Alignment );
+		}
+
+		virtual void* TryRealloc( void* Original, const SIZE_T Count, const uint32 Alignment ) override
+		{
+			if( Count > 0 )
+				CountAllocation();
+
+			return Inner->TryRealloc( Original, Count, Alignment );
+		}
+
+		virtual void Free( void* Original ) override { Inner->Free( Original ); }
+
+		virtual SIZE_T QuantizeSize( const SIZE_T Count, const uint32 Alignment ) override { return Inner->QuantizeSize( Count, Alignment ); }
+		virtual bool   GetAllocationSize( void* Original, SIZE_T& SizeOut ) override { return Inner->GetAllocationSize( Original, SizeOut ); }
+		virtual bool   IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT( "ScopedAllocationCounter" ); }
+
+	private:
+		void CountAllocation()
+		{
+			if( FPlatformTLS::GetCurrentThreadId() == ThreadId )
+				++NumAllocations;
+		}
+
+		FMalloc*     Inner;
+		const uint32 ThreadId;
+		int32        NumAllocations = 0;
+	};
+
+	/**
+	 * Size x Size columns of ground Height voxels high, with HoleFraction of the voxels in the top Depth layers mined out.
+	 * Types alternate between ground and stone by layer, Seed makes the holes reproducible.
+	 */
+	inline FChunkVoxels MakeVoxels( const int32 Size, const int32 Height, const int32 Depth, const float HoleFraction, const int32 Seed )
+	{
+		FChunkVoxels Voxels( FIntVector::ZeroValue, FIntVector( Size, Size, Height + 1 ) );
+
+		const FRandomStream Random( Seed );
+		for( int32 Q = 0; Q < Size; ++Q )
+		{
+			for( int32 R = 0; R < Size; ++R )
+			{
+				Voxels.SetColumn( Q, R, Height, EVoxelType::Ground );
+
+				for( int32 Z = 0; Z < Height; Z += 2 )
+					Voxels.SetType( FIntVector( Q, R, Z ), EVoxelType::Stone );
+
+				for( int32 Z = Height - Depth; Z < Height; ++Z )
+				{
+					if( Random.FRand() < HoleFraction )
+						Voxels.SetType( FIntVector( Q, R, Z ), EVoxelType::Air );
+				}
+			}
+		}
+
+		return Voxels;
+	}
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "Components/BoxComponent.h"
 #include "GameFramework/FloatingPawnMovement.h"
+#include "UnnamedFactoryGame/World/Generation/WorldGenerationSubSystem.h"
 #include "UnnamedFactoryGame/World/Pathfinding/NavigationComponent.h"
 
 ABaseUnit::ABaseUnit()
@@ -23,6 +24,22 @@ ABaseUnit::ABaseUnit()
 	NavigationComponent = CreateDefaultSubobject< UNavigationComponent >( TEXT( "NavigationComponent" ) );
 }
 
+void ABaseUnit::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if( UWorldGenerationSubSystem* WorldGenerationSubSystem = UWorldGenerationSubSystem::Get( this ) )
+		WorldGenerationSubSystem->AddCollisionSource( this );
+}
+
+void ABaseUnit::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	if( UWorldGenerationSubSystem* WorldGenerationSubSystem = UWorldGenerationSubSystem::Get( this ) )
+		WorldGenerationSubSystem->RemoveCollisionSource( this );
+
+	Super::EndPlay( EndPlayReason );
+}
+
 void ABaseUnit::Tick( const float DeltaSeconds )
 {
 	Super::Tick( DeltaSeconds );
@@ -40,5 +57,6 @@ void ABaseUnit::Tick( const float DeltaSeconds )
 
 void ABaseUnit::MoveTo( const FVector& Location )
 {
-	NavigationComponent->CalculatePath( Location, CurrentPath );
+	// The unit keeps following its current path until the new one arrives
+	NavigationComponent->RequestPath( Location, [ this ]( TArray< FHexagonVoxel >&& Path ) { CurrentPath = MoveTemp( Path ); } );
 }
@@ -20,6 +20,8 @@ class UNNAMEDFACTORYGAME_API ABaseUnit : public AActor
 public:
 	ABaseUnit();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay( EEndPlayReason::Type EndPlayReason ) override;
 	virtual void Tick( float DeltaSeconds ) override;
 
 	UFUNCTION( BlueprintCallable )
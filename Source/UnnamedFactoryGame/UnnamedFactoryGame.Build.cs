@@ -8,8 +8,8 @@ public class UnnamedFactoryGame : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange( new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "ProceduralMeshComponent", "GeometryCore" } );
+		PublicDependencyModuleNames.AddRange( new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "PhysicsCore", "RenderCore" } );
 
-		PrivateDependencyModuleNames.AddRange( new string[] {} );
+		PrivateDependencyModuleNames.AddRange( new string[] { "RHI" } );
 	}
 }
\ No newline at end of file
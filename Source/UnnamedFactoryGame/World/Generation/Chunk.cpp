@@ -2,96 +2,93 @@
 
 #include "Chunk.h"
 
-#include "CompGeom/PolygonTriangulation.h"
-#include "Components/HierarchicalInstancedStaticMeshComponent.h"
-#include "ProceduralHexagonMeshComponent.h"
-#include "WorldPartition/WorldPartition.h"
+int32 FChunk::StaticSize          = 16;
+int32 FChunk::StaticHeight        = 32;
+int32 FChunk::StaticSectionHeight = 8;
 
-int32 AChunk::StaticSize       = 0;
-int32 AChunk::StaticHeight     = 0;
-float AChunk::StaticNoiseScale = 0;
-
-AChunk::AChunk()
+FVector FChunk::ChunkToWorld( const FIntPoint& ChunkCoordinate )
 {
-	PrimaryActorTick.bCanEverTick = false;
-
-	RootComponent = CreateDefaultSubobject< USceneComponent >( TEXT( "RootComponent" ) );
-	Mesh          = CreateDefaultSubobject< UProceduralHexagonMeshComponent >( TEXT( "Mesh" ) );
-
-	StaticSize       = Size;
-	StaticHeight     = Height;
-	StaticNoiseScale = NoiseScale;
+	return FHexagonVoxel::VoxelToWorld( FIntVector( ChunkCoordinate.X * StaticSize, ChunkCoordinate.Y * StaticSize, 0 ) );
 }
 
-void AChunk::Generate( const FIntPoint& ChunkCoordinate )
+FIntPoint FChunk::VoxelToChunk( const FIntVector& VoxelCoordinate )
 {
-	Coordinate = ChunkCoordinate;
-
-	GenerateVoxels();
+	const int32 X = FMath::FloorToInt( static_cast< float >( VoxelCoordinate.X ) / StaticSize );
+	const int32 Y = FMath::FloorToInt( static_cast< float >( VoxelCoordinate.Y ) / StaticSize );
+	return FIntPoint( X, Y );
 }
 
-void AChunk::SetVisible()
+FIntPoint FChunk::WorldToChunk( const FVector& WorldLocation )
 {
-	Mesh->SetVisibility( true );
-	GetWorld()->GetTimerManager().SetTimer( VisibilityTimer, [ this ] { Mesh->SetVisibility( false ); }, 1, false );
-	GetWorld()->GetTimerManager().SetTimer( LoadedTimer, [ this ] { Destroy(); }, 30, false );
+	const FIntVector VoxelCoordinate = FHexagonVoxel::WorldToVoxel( WorldLocation );
+	return VoxelToChunk( VoxelCoordinate );
 }
 
-FVector AChunk::ChunkToWorld( const FIntPoint& ChunkCoordinate )
+uint32 FChunk::GetSectionMask( const int32 Bottom, const int32 Top )
 {
-	return FHexagonVoxel::VoxelToWorld( FIntVector( ChunkCoordinate.X * StaticSize, ChunkCoordinate.Y * StaticSize, 0 ) );
+	const int32 ClampedBottom = FMath::Max( Bottom, 0 );
+	const int32 ClampedTop    = FMath::Min( Top, StaticHeight );
+
+	uint32 Mask = 0;
+	for( int32 Section = ClampedBottom / StaticSectionHeight; ClampedBottom < ClampedTop && Section * StaticSectionHeight < ClampedTop; ++Section )
+		Mask |= 1u << Section;
+
+	return Mask;
 }
 
-FIntPoint AChunk::VoxelToChunk( const FIntVector& VoxelCoordinate )
+void FChunk::GetSectionLayers( const uint32 Sections, int32& OutBottom, int32& OutTop )
 {
-	const int32 X = FMath::FloorToInt( static_cast< float >( VoxelCoordinate.X ) / StaticSize );
-	const int32 Y = FMath::FloorToInt( static_cast< float >( VoxelCoordinate.Y ) / StaticSize );
-	return FIntPoint( X, Y );
+	if( !Sections )
+	{
+		OutBottom = OutTop = 0;
+		return;
+	}
+
+	OutBottom = FMath::Max( static_cast< int32 >( FMath::CountTrailingZeros( Sections ) ) * StaticSectionHeight - 1, 0 );
+	OutTop    = FMath::Min( static_cast< int32 >( 32 - FMath::CountLeadingZeros( Sections ) ) * StaticSectionHeight + 1, StaticHeight );
 }
 
-FIntPoint AChunk::WorldToChunk( const FVector& WorldLocation )
+void FChunk::ForEachBorderColumn( const FIntPoint& ChunkCoordinate, const TFunctionRef< void( const FIntPoint& ) > Function )
 {
-	const FIntVector VoxelCoordinate = FHexagonVoxel::WorldToVoxel( WorldLocation );
-	return VoxelToChunk( VoxelCoordinate );
+	const FIntPoint Min = ChunkCoordinate * StaticSize - FIntPoint( 1 );
+	const FIntPoint Max = Min + FIntPoint( StaticSize + 1 );
+
+	for( int32 Q = Min.X; Q <= Max.X; ++Q )
+	{
+		const bool IsEdge = Q == Min.X || Q == Max.X;
+		for( int32 R = Min.Y; R <= Max.Y; R += IsEdge ? 1 : Max.Y - Min.Y )
+			Function( FIntPoint( Q, R ) );
+	}
 }
 
-void AChunk::GenerateVoxels()
+FChunkVoxels FChunk::MakePaddedVoxels( const FChunkVoxels& Voxels, const TConstArrayView< EVoxelType > Border, const int32 Bottom, const int32 Top )
 {
-	HexagonTiles.Empty();
-
-	AsyncTask( ENamedThreads::AnyBackgroundThreadNormalTask,
-	           [ this ]
-	           {
-				   const int32 QOffset = Coordinate.X * Size;
-				   const int32 ROffset = Coordinate.Y * Size;
-
-				   TMap< FIntVector, FHexagonVoxel > HexagonVoxels;
-				   for( int32 Q = -1; Q <= Size; ++Q )
-				   {
-					   for( int32 R = -1; R <= Size; ++R )
-					   {
-						   const float PerlinNoise = FMath::PerlinNoise2D( FVector2D( Q + QOffset, R + ROffset ) * NoiseScale );
-						   const int64 TileHeight  = FMath::RoundToInt( FMath::GetMappedRangeValueClamped( FVector2D( -1.0f, 1.0f ), FVector2D( 0, Height ), PerlinNoise ) );
-
-						   for( int32 Z = 0; Z < Height; ++Z )
-						   {
-							   const EVoxelType Type            = Z > TileHeight ? EVoxelType::Air : EVoxelType::Ground;
-							   FIntVector       VoxelCoordinate = { Q + QOffset, R + ROffset, Z };
-							   FHexagonVoxel    Voxel( VoxelCoordinate, Type );
-							   HexagonVoxels.Add( VoxelCoordinate, Voxel );
-						   }
-					   }
-				   }
-
-				   static FSkipGenerationDelegate SkipGenerationDelegate;
-				   SkipGenerationDelegate.BindLambda(
-					   [ this, QOffset, ROffset ]( const FHexagonVoxel& Voxel )
-					   {
-						   const FIntVector& VoxelCoordinate = Voxel.GridLocation;
-						   return VoxelCoordinate.X == QOffset - 1 || VoxelCoordinate.X == QOffset + Size || VoxelCoordinate.Y == ROffset - 1
-			                   || VoxelCoordinate.Y == ROffset + Size;
-					   } );
-
-				   Mesh->Generate( HexagonVoxels, true, SkipGenerationDelegate );
-			   } );
+	const FIntVector& Origin = Voxels.GetOrigin();
+	const FIntVector& Extent = Voxels.GetExtent();
+	const int32       Height = Top - Bottom;
+
+	// ForEachBorderColumn walks the ring q major like the padded block stores its columns, so the border is read front to back
+	int32 Offset = 0;
+
+	FChunkVoxels Padded;
+	Padded.InitColumns( FIntVector( Origin.X - 1, Origin.Y - 1, Origin.Z + Bottom ),
+	                    FIntVector( Extent.X + 2, Extent.Y + 2, Height ),
+	                    [ & ]( const FIntPoint& ColumnCoordinate, const TArrayView< EVoxelType > OutTypes )
+	                    {
+							if( Voxels.IsColumnInside( ColumnCoordinate ) )
+							{
+								Voxels.GetColumnTypes( ColumnCoordinate, Bottom, OutTypes );
+								return;
+							}
+
+							if( Border.Num() >= Offset + Height )
+								FMemory::Memcpy( OutTypes.GetData(), Border.GetData() + Offset, Height * sizeof( EVoxelType ) );
+							else
+								for( EVoxelType& Type: OutTypes )
+									Type = EVoxelType::Air;
+
+							Offset += Height;
+						} );
+
+	return Padded;
 }
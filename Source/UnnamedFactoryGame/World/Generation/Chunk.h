@@ -2,57 +2,89 @@
 
 #pragma once
 
+#include "ChunkVoxels.h"
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
 #include "HexagonVoxel.h"
+#include "ProceduralHexagonMeshComponent.h"
+#include "UnnamedFactoryGame/World/Pathfinding/ChunkWalkGraph.h"
+
+/**
+ * Runtime state of a streamed chunk, owned by UWorldGenerationSubSystem.
+ * Rendering borrows a component from AChunkMeshPool while the chunk is shown.
+ */
+struct UNNAMEDFACTORYGAME_API FChunk
+{
+	FChunk() = default;
+	explicit FChunk( const FIntPoint& InCoordinate )
+		: Coordinate( InCoordinate )
+	{}
 
-#include "Chunk.generated.h"
-
-class UProceduralHexagonMeshComponent;
-class UHierarchicalInstancedStaticMeshComponent;
+	bool GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const { return FHexagonVoxel::GetVoxel( Voxels, VoxelCoordinate, OutVoxel ); }
+	bool GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel ) const { return FHexagonVoxel::GetVoxel( Voxels, WorldLocation, OutVoxel ); }
 
-UCLASS( Abstract )
-class UNNAMEDFACTORYGAME_API AChunk : public AActor
-{
-	GENERATED_BODY()
+	const FChunkVoxels& GetVoxels() const { return Voxels; }
 
-public:
-	AChunk();
+	const FIntPoint& GetCoordinate() const { return Coordinate; }
 
-	void Generate( const FIntPoint& ChunkCoordinate );
+	static int32 GetSize() { return StaticSize; }
+	static int32 GetHeight() { return StaticHeight; }
+	static int32 GetSectionHeight() { return StaticSectionHeight; }
+	static int32 GetNumSections() { return FMath::DivideAndRoundUp( StaticHeight, StaticSectionHeight ); }
 
-	void SetVisible();
+	/** Bits of the mesh sections holding faces that lie in the local layers [Bottom, Top) */
+	static uint32 GetSectionMask( int32 Bottom, int32 Top );
+	static uint32 GetAllSections() { return GetSectionMask( 0, StaticHeight ); }
 
-	bool GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const { return FHexagonVoxel::GetVoxel( HexagonTiles, VoxelCoordinate, OutVoxel ); }
-	bool GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel ) const { return FHexagonVoxel::GetVoxel( HexagonTiles, WorldLocation, OutVoxel ); }
+	/** Local layers [OutBottom, OutTop) meshing Sections needs, theirs plus the layer on either side hiding their top and bottom faces */
+	static void GetSectionLayers( uint32 Sections, int32& OutBottom, int32& OutTop );
 
 	static FVector ChunkToWorld( const FIntPoint& ChunkCoordinate );
 
 	static FIntPoint VoxelToChunk( const FIntVector& VoxelCoordinate );
 	static FIntPoint WorldToChunk( const FVector& WorldLocation );
 
-protected:
-	UPROPERTY( EditDefaultsOnly, BlueprintReadWrite, Category = "Chunk" )
-	TObjectPtr< UProceduralHexagonMeshComponent > Mesh;
+	/** Visits the ring of columns just outside the chunk that its border faces look at */
+	static void ForEachBorderColumn( const FIntPoint& ChunkCoordinate, TFunctionRef< void( const FIntPoint& ) > Function );
 
-private:
-	void GenerateVoxels();
+	/**
+	 * Copies the local layers [Bottom, Top) of Voxels into a block one column wider on every side, filling the ring from Border in ForEachBorderColumn order.
+	 * Border holds those layers of every ring column. Meshing the result with FChunkMeshPolicy gives the chunk the correct faces along its border.
+	 */
+	static FChunkVoxels MakePaddedVoxels( const FChunkVoxels& Voxels, TConstArrayView< EVoxelType > Border, int32 Bottom, int32 Top );
+
+	FIntPoint    Coordinate = FIntPoint::ZeroValue;
+	FChunkVoxels Voxels;
+
+	TWeakObjectPtr< UProceduralHexagonMeshComponent > Mesh;
 
-	TMap< FIntVector, FHexagonVoxel > HexagonTiles;
+	/** Built once the voxels are ready and patched around every edit, empty while they are missing */
+	FChunkWalkGraph WalkGraph;
 
-	FIntPoint Coordinate = FIntPoint::ZeroValue;
+	/** Within GenerationDistance of the player, otherwise LeftRangeTime is when it left */
+	bool   IsInRange     = false;
+	double LeftRangeTime = 0;
 
-	UPROPERTY( EditDefaultsOnly, Category = "Chunk" )
-	int32 Size = 16;
-	UPROPERTY( EditDefaultsOnly, Category = "Chunk" )
-	int32 Height = 32;
-	UPROPERTY( EditDefaultsOnly, Category = "Chunk" )
-	float NoiseScale = .02f;
+	/** Detail level the mesh is built at, 0 is full detail and the only one with collision */
+	int32 Lod = 0;
 
-	FTimerHandle VisibilityTimer;
-	FTimerHandle LoadedTimer;
+	bool IsMeshPending = false;
+
+	/** Mesh sections built from outdated voxels, section i holds the faces of layers [i, i + 1) * GetSectionHeight() */
+	uint32 DirtySections = 0;
+
+	/** Bumped by every mesh request, only the latest one marks its sections clean */
+	uint32 MeshRequestId = 0;
+
+	/** Bit i is set when the mesh was built without the chunk at Coordinate + CoordinateDirections[ i ] */
+	uint8 MissingNeighbours = 0;
+
+	/** Set when the voxels differ from the saved copy on disk */
+	bool HasUnsavedChanges = false;
+
+private:
+	friend class UWorldGenerationSubSystem;
 
 	static int32 StaticSize;
 	static int32 StaticHeight;
-	static float StaticNoiseScale;
+	static int32 StaticSectionHeight;
 };
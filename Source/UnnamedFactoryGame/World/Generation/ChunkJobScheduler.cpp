@@ -0,0 +1,103 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkJobScheduler.h"
+
+FChunkJobScheduler::FChunkJobScheduler( const int32 InMaxConcurrentJobs )
+	: MaxConcurrentJobs( InMaxConcurrentJobs > 0 ? InMaxConcurrentJobs : FMath::Max( FTaskGraphInterface::Get().GetNumWorkerThreads() - 1, 1 ) )
+{}
+
+FChunkJobScheduler::~FChunkJobScheduler()
+{
+	Wait();
+}
+
+void FChunkJobScheduler::Add( const FIntPoint& Coordinate, const EChunkJobType Type, const float Priority, FWork&& Work )
+{
+	const FJobKey Key( Coordinate, Type );
+
+	const int32 NumRemoved = PendingJobs.RemoveAll( [ &Key ]( const FPendingJob& Job ) { return Job.Key == Key; } );
+	if( NumRemoved > 0 )
+		PendingJobs.Heapify();
+
+	const uint32 Id = ++LastJobId;
+	LatestJobs.Add( Key, Id );
+	PendingJobs.HeapPush( FPendingJob{ .Id = Id, .Key = Key, .Priority = Priority, .Work = MoveTemp( Work ) } );
+}
+
+void FChunkJobScheduler::Cancel( const FIntPoint& Coordinate )
+{
+	const int32 NumRemoved = PendingJobs.RemoveAll( [ &Coordinate ]( const FPendingJob& Job ) { return Job.Key.Key == Coordinate; } );
+	if( NumRemoved > 0 )
+		PendingJobs.Heapify();
+
+	LatestJobs.Remove( FJobKey( Coordinate, EChunkJobType::Voxels ) );
+	LatestJobs.Remove( FJobKey( Coordinate, EChunkJobType::Mesh ) );
+}
+
+void FChunkJobScheduler::Reprioritize( const TFunctionRef< bool( const FIntPoint&, EChunkJobType, float& ) > PriorityFunction )
+{
+	if( PendingJobs.IsEmpty() )
+		return;
+
+	for( int32 i = PendingJobs.Num() - 1; i >= 0; --i )
+	{
+		FPendingJob& Job = PendingJobs[ i ];
+		if( PriorityFunction( Job.Key.Key, Job.Key.Value, Job.Priority ) )
+			continue;
+
+		LatestJobs.Remove( Job.Key );
+		PendingJobs.RemoveAtSwap( i, EAllowShrinking::No );
+	}
+
+	PendingJobs.Heapify();
+}
+
+void FChunkJobScheduler::Update( const double EndTime )
+{
+	bool Delivered = false;
+	while( const FFinishedJob* NextJob = FinishedJobs.Peek() )
+	{
+		// Superseded jobs are dropped regardless of the time left, they cost nothing to deliver
+		const uint32* LatestId = LatestJobs.Find( NextJob->Key );
+		const bool    IsLatest = LatestId && *LatestId == NextJob->Id;
+		if( IsLatest && Delivered && FPlatformTime::Seconds() >= EndTime )
+			break;
+
+		FFinishedJob FinishedJob;
+		FinishedJobs.Dequeue( FinishedJob );
+		NumFinishedJobs.fetch_sub( 1, std::memory_order_relaxed );
+		--NumRunningJobs;
+
+		if( !IsLatest )
+			continue;
+
+		LatestJobs.Remove( FinishedJob.Key );
+		if( FinishedJob.Completion )
+			FinishedJob.Completion();
+
+		Delivered = true;
+	}
+
+	Tasks.RemoveAllSwap( []( const UE::Tasks::FTask& Task ) { return Task.IsCompleted(); } );
+
+	while( NumRunningJobs < MaxConcurrentJobs && !PendingJobs.IsEmpty() )
+	{
+		FPendingJob Job;
+		PendingJobs.HeapPop( Job, EAllowShrinking::No );
+		++NumRunningJobs;
+
+		Tasks.Add( UE::Tasks::Launch( UE_SOURCE_LOCATION,
+		                              [ this, Id = Job.Id, Key = Job.Key, Work = MoveTemp( Job.Work ) ]() mutable
+		                              {
+										  FCompletion Completion = Work();
+										  NumFinishedJobs.fetch_add( 1, std::memory_order_relaxed );
+										  FinishedJobs.Enqueue( FFinishedJob{ .Id = Id, .Key = Key, .Completion = MoveTemp( Completion ) } );
+									  } ) );
+	}
+}
+
+void FChunkJobScheduler::Wait()
+{
+	UE::Tasks::Wait( Tasks );
+	Tasks.Empty();
+}
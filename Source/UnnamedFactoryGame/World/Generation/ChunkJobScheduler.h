@@ -0,0 +1,96 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Containers/Queue.h"
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+#include <atomic>
+
+enum class EChunkJobType : uint8
+{
+	Voxels,
+	Mesh,
+};
+
+/**
+ * Runs chunk jobs on worker threads, most important first and with a limited number in flight.
+ * Every job gets an id and only the latest job of a chunk and type delivers its completion,
+ * so superseded or cancelled work is dropped even when it was already running.
+ */
+class UNNAMEDFACTORYGAME_API FChunkJobScheduler
+{
+public:
+	using FCompletion = TUniqueFunction< void() >;
+	using FWork       = TUniqueFunction< FCompletion() >;
+
+	explicit FChunkJobScheduler( int32 InMaxConcurrentJobs );
+	~FChunkJobScheduler();
+
+	/**
+	 * Queues Work, replacing any pending or running job of the same chunk and type.
+	 * Work runs on a worker thread, the completion it returns runs on the game thread during Update.
+	 * @param Priority Lower runs first
+	 */
+	void Add( const FIntPoint& Coordinate, EChunkJobType Type, float Priority, FWork&& Work );
+
+	/** Drops every job of the chunk, running ones finish but their completions are discarded */
+	void Cancel( const FIntPoint& Coordinate );
+
+	/**
+	 * Recomputes the priority of every pending job.
+	 * PriorityFunction( Coordinate, Type, OutPriority ) returns false to cancel the job.
+	 */
+	void Reprioritize( TFunctionRef< bool( const FIntPoint&, EChunkJobType, float& ) > PriorityFunction );
+
+	/**
+	 * Delivers finished jobs and starts pending ones until the concurrency limit is reached.
+	 * Stops delivering at EndTime in FPlatformTime::Seconds, at least one completion still runs so the queue keeps moving.
+	 * Undelivered jobs keep counting towards the concurrency limit.
+	 */
+	void Update( double EndTime = TNumericLimits< double >::Max() );
+
+	/** Blocks until every running job has finished, their completions stay queued */
+	void Wait();
+
+	int32 GetNumPending() const { return PendingJobs.Num(); }
+	int32 GetNumRunning() const { return NumRunningJobs - NumFinishedJobs.load( std::memory_order_relaxed ); }
+	int32 GetNumFinished() const { return NumFinishedJobs.load( std::memory_order_relaxed ); }
+
+private:
+	using FJobKey = TPair< FIntPoint, EChunkJobType >;
+
+	struct FPendingJob
+	{
+		uint32  Id;
+		FJobKey Key;
+		float   Priority;
+		FWork   Work;
+
+		bool operator<( const FPendingJob& Other ) const { return Priority < Other.Priority; }
+	};
+
+	struct FFinishedJob
+	{
+		uint32      Id;
+		FJobKey     Key;
+		FCompletion Completion;
+	};
+
+	TArray< FPendingJob > PendingJobs;
+
+	/** Id of the job allowed to complete for each chunk and type */
+	TMap< FJobKey, uint32 > LatestJobs;
+
+	TQueue< FFinishedJob, EQueueMode::Mpsc > FinishedJobs;
+
+	TArray< UE::Tasks::FTask > Tasks;
+
+	/** Finished jobs waiting in FinishedJobs */
+	std::atomic< int32 > NumFinishedJobs = 0;
+
+	uint32 LastJobId         = 0;
+	int32  NumRunningJobs    = 0;
+	int32  MaxConcurrentJobs = 1;
+};
@@ -0,0 +1,48 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkMeshPool.h"
+
+#include "ProceduralHexagonMeshComponent.h"
+
+AChunkMeshPool::AChunkMeshPool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject< USceneComponent >( TEXT( "RootComponent" ) );
+}
+
+void AChunkMeshPool::Init( const int32 PoolSize, UMaterialInterface* Material )
+{
+	Components.Reserve( PoolSize );
+	FreeComponents.Reserve( PoolSize );
+
+	for( int32 i = 0; i < PoolSize; ++i )
+	{
+		UProceduralHexagonMeshComponent* MeshComponent = NewObject< UProceduralHexagonMeshComponent >( this, NAME_None, RF_Transient );
+		MeshComponent->SetupAttachment( RootComponent );
+		MeshComponent->SetMaterial( 0, Material );
+		MeshComponent->SetVisibility( false );
+		MeshComponent->RegisterComponent();
+
+		Components.Add( MeshComponent );
+		FreeComponents.Add( MeshComponent );
+	}
+}
+
+UProceduralHexagonMeshComponent* AChunkMeshPool::Acquire()
+{
+	if( FreeComponents.IsEmpty() )
+		return nullptr;
+
+	return FreeComponents.Pop( EAllowShrinking::No );
+}
+
+void AChunkMeshPool::Release( UProceduralHexagonMeshComponent* MeshComponent )
+{
+	if( !MeshComponent )
+		return;
+
+	MeshComponent->ClearMesh();
+	MeshComponent->SetVisibility( false );
+	FreeComponents.Add( MeshComponent );
+}
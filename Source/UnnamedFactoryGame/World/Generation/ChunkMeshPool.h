@@ -0,0 +1,36 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "ChunkMeshPool.generated.h"
+
+class UProceduralHexagonMeshComponent;
+
+/**
+ * Owns a fixed set of chunk mesh components that are handed out to streamed chunks and recycled afterwards
+ */
+UCLASS( NotPlaceable, Transient )
+class UNNAMEDFACTORYGAME_API AChunkMeshPool : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AChunkMeshPool();
+
+	void Init( int32 PoolSize, UMaterialInterface* Material );
+
+	UProceduralHexagonMeshComponent* Acquire();
+	void                             Release( UProceduralHexagonMeshComponent* MeshComponent );
+
+	int32 GetNumFree() const { return FreeComponents.Num(); }
+
+private:
+	UPROPERTY()
+	TArray< TObjectPtr< UProceduralHexagonMeshComponent > > Components;
+
+	UPROPERTY()
+	TArray< TObjectPtr< UProceduralHexagonMeshComponent > > FreeComponents;
+};
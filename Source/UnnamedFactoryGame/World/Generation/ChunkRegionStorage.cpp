@@ -0,0 +1,217 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkRegionStorage.h"
+
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UnnamedFactoryGame/UnnamedFactoryGame.h"
+
+namespace
+{
+	constexpr uint32 RegionMagic   = 0x47525848; // "HXRG"
+	constexpr uint32 RegionVersion = 2;
+
+	constexpr int32 RegionSlots      = FChunkRegionStorage::RegionSize * FChunkRegionStorage::RegionSize;
+	constexpr int32 RegionHeaderSize = sizeof( uint32 ) * 2 + RegionSlots * sizeof( int32 ) * 2;
+}
+
+FChunkRegionStorage::FChunkRegionStorage( const FString& InDirectory )
+	: Directory( InDirectory )
+{
+	IFileManager::Get().MakeDirectory( *Directory, true );
+}
+
+FChunkRegionStorage::~FChunkRegionStorage()
+{
+	Flush();
+}
+
+void FChunkRegionStorage::LoadChunk( const FIntPoint& ChunkCoordinate, TUniqueFunction< void( TOptional< FChunkVoxels >&& ) > OnLoaded )
+{
+	Pipe.Launch( UE_SOURCE_LOCATION,
+	             [ this, ChunkCoordinate, OnLoaded = MoveTemp( OnLoaded ) ]() mutable
+	             {
+					 TOptional< FChunkVoxels > Voxels = ReadChunk( ChunkCoordinate );
+					 AsyncTask( ENamedThreads::GameThread, [ OnLoaded = MoveTemp( OnLoaded ), Voxels = MoveTemp( Voxels ) ]() mutable { OnLoaded( MoveTemp( Voxels ) ); } );
+				 } );
+}
+
+void FChunkRegionStorage::SaveChunk( const FIntPoint& ChunkCoordinate, FChunkVoxels&& Voxels )
+{
+	Pipe.Launch( UE_SOURCE_LOCATION,
+	             [ this, ChunkCoordinate, Voxels = MoveTemp( Voxels ) ]() mutable
+	             {
+					 TArray< uint8 > ChunkData;
+					 FMemoryWriter   Writer( ChunkData );
+					 Writer << Voxels;
+
+					 WriteChunk( ChunkCoordinate, ChunkData );
+				 } );
+}
+
+void FChunkRegionStorage::Flush()
+{
+	Pipe.WaitUntilEmpty();
+}
+
+FString FChunkRegionStorage::GetRegionFilename( const FIntPoint& RegionCoordinate ) const
+{
+	return FPaths::Combine( Directory, FString::Printf( TEXT( "Region_%d_%d.bin" ), RegionCoordinate.X, RegionCoordinate.Y ) );
+}
+
+FIntPoint FChunkRegionStorage::GetRegionCoordinate( const FIntPoint& ChunkCoordinate )
+{
+	return FIntPoint( FMath::FloorToInt( static_cast< float >( ChunkCoordinate.X ) / RegionSize ), FMath::FloorToInt( static_cast< float >( ChunkCoordinate.Y ) / RegionSize ) );
+}
+
+int32 FChunkRegionStorage::GetRegionSlot( const FIntPoint& ChunkCoordinate )
+{
+	const FIntPoint Local = ChunkCoordinate - GetRegionCoordinate( ChunkCoordinate ) * RegionSize;
+	return Local.X * RegionSize + Local.Y;
+}
+
+TOptional< FChunkVoxels > FChunkRegionStorage::ReadChunk( const FIntPoint& ChunkCoordinate ) const
+{
+	const FString             Filename = GetRegionFilename( GetRegionCoordinate( ChunkCoordinate ) );
+	TUniquePtr< IFileHandle > File( FPlatformFileManager::Get().GetPlatformFile().OpenRead( *Filename ) );
+	if( !File )
+		return {};
+
+	uint32 Header[ 2 ];
+	if( !File->Read( reinterpret_cast< uint8* >( Header ), sizeof( Header ) ) || Header[ 0 ] != RegionMagic || Header[ 1 ] != RegionVersion )
+		return {};
+
+	FRegionEntry Entry;
+	if( !File->Seek( sizeof( Header ) + GetRegionSlot( ChunkCoordinate ) * sizeof( FRegionEntry ) ) || !File->Read( reinterpret_cast< uint8* >( &Entry ), sizeof( Entry ) ) )
+		return {};
+
+	// A corrupt header must not size the allocation below
+	if( Entry.Size <= 0 || Entry.Offset < RegionHeaderSize || static_cast< int64 >( Entry.Offset ) + Entry.Size > File->Size() )
+		return {};
+
+	TArray< uint8 > ChunkData;
+	ChunkData.SetNumUninitialized( Entry.Size );
+	if( !File->Seek( Entry.Offset ) || !File->Read( ChunkData.GetData(), Entry.Size ) )
+		return {};
+
+	FChunkVoxels  Voxels;
+	FMemoryReader Reader( ChunkData );
+	Reader << Voxels;
+
+	if( Reader.IsError() )
+	{
+		UE_LOG( UnnamedFactoryGameLog, Warning, TEXT( "Discarding corrupt chunk %d, %d in %s" ), ChunkCoordinate.X, ChunkCoordinate.Y, *Filename )
+		return {};
+	}
+
+	return Voxels;
+}
+
+void FChunkRegionStorage::WriteChunk( const FIntPoint& ChunkCoordinate, const TArray< uint8 >& ChunkData ) const
+{
+	const FString Filename = GetRegionFilename( GetRegionCoordinate( ChunkCoordinate ) );
+	const int32   Slot     = GetRegionSlot( ChunkCoordinate );
+
+	IPlatformFile&            PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr< IFileHandle > File( PlatformFile.OpenWrite( *Filename, true, true ) );
+	if( !File )
+	{
+		UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Failed to open region %s" ), *Filename )
+		return;
+	}
+
+	TArray< uint8 > HeaderData;
+	HeaderData.SetNumZeroed( RegionHeaderSize );
+
+	uint32*       Header  = reinterpret_cast< uint32* >( HeaderData.GetData() );
+	FRegionEntry* Entries = reinterpret_cast< FRegionEntry* >( Header + 2 );
+
+	int64 FileSize = File->Size();
+	if( FileSize < RegionHeaderSize || !File->Seek( 0 ) || !File->Read( HeaderData.GetData(), RegionHeaderSize ) || Header[ 0 ] != RegionMagic || Header[ 1 ] != RegionVersion )
+	{
+		// Nothing in the file can be read back, so it starts over behind a fresh header
+		FMemory::Memzero( HeaderData.GetData(), RegionHeaderSize );
+		Header[ 0 ] = RegionMagic;
+		Header[ 1 ] = RegionVersion;
+
+		if( !File->Seek( 0 ) || !File->Write( HeaderData.GetData(), RegionHeaderSize ) )
+		{
+			UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Failed to write region %s" ), *Filename )
+			return;
+		}
+
+		FileSize = FMath::Max< int64 >( FileSize, RegionHeaderSize );
+	}
+
+	// Compaction keeps a region within twice its live data, so only a region of absurd chunks gets here
+	if( FileSize + ChunkData.Num() > MAX_int32 )
+	{
+		UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Region %s is full" ), *Filename )
+		return;
+	}
+
+	// The old data stays until the slot points past it, a save cut short leaves the previous chunk readable
+	const FRegionEntry Entry{ .Offset = static_cast< int32 >( FileSize ), .Size = ChunkData.Num() };
+	if( !File->Seek( Entry.Offset ) || !File->Write( ChunkData.GetData(), Entry.Size ) )
+	{
+		UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Failed to write region %s" ), *Filename )
+		return;
+	}
+
+	Entries[ Slot ] = Entry;
+	if( !File->Seek( sizeof( uint32 ) * 2 + Slot * sizeof( FRegionEntry ) ) || !File->Write( reinterpret_cast< const uint8* >( &Entry ), sizeof( Entry ) ) || !File->Flush() )
+	{
+		UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Failed to write region %s" ), *Filename )
+		return;
+	}
+
+	File.Reset();
+
+	int64 LiveSize = 0;
+	for( int32 i = 0; i < RegionSlots; ++i )
+		LiveSize += FMath::Max( Entries[ i ].Size, 0 );
+
+	// Compacting once the stale data outgrows the live data keeps every saved byte copied a bounded number of times
+	if( FileSize + Entry.Size - RegionHeaderSize > LiveSize * 2 )
+		CompactRegion( Filename );
+}
+
+void FChunkRegionStorage::CompactRegion( const FString& Filename ) const
+{
+	TArray< uint8 > RegionData;
+	if( !FFileHelper::LoadFileToArray( RegionData, *Filename, FILEREAD_Silent ) || RegionData.Num() < RegionHeaderSize )
+		return;
+
+	const uint32*       Header  = reinterpret_cast< const uint32* >( RegionData.GetData() );
+	const FRegionEntry* Entries = reinterpret_cast< const FRegionEntry* >( Header + 2 );
+	if( Header[ 0 ] != RegionMagic || Header[ 1 ] != RegionVersion )
+		return;
+
+	TArray< uint8 > CompactData;
+	CompactData.AddZeroed( RegionHeaderSize );
+
+	uint32* CompactHeader = reinterpret_cast< uint32* >( CompactData.GetData() );
+	CompactHeader[ 0 ]    = RegionMagic;
+	CompactHeader[ 1 ]    = RegionVersion;
+
+	for( int32 i = 0; i < RegionSlots; ++i )
+	{
+		const FRegionEntry& Entry = Entries[ i ];
+		if( Entry.Size <= 0 || Entry.Offset < RegionHeaderSize || static_cast< int64 >( Entry.Offset ) + Entry.Size > RegionData.Num() )
+			continue;
+
+		const FRegionEntry CompactEntry{ .Offset = CompactData.Num(), .Size = Entry.Size };
+		CompactData.Append( RegionData.GetData() + Entry.Offset, Entry.Size );
+
+		FMemory::Memcpy( CompactData.GetData() + sizeof( uint32 ) * 2 + i * sizeof( FRegionEntry ), &CompactEntry, sizeof( CompactEntry ) );
+	}
+
+	const FString TempFilename = Filename + TEXT( ".tmp" );
+	if( !FFileHelper::SaveArrayToFile( CompactData, *TempFilename ) || !IFileManager::Get().Move( *Filename, *TempFilename, true, true ) )
+		UE_LOG( UnnamedFactoryGameLog, Error, TEXT( "Failed to compact region %s" ), *Filename )
+}
@@ -0,0 +1,48 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ChunkVoxels.h"
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+
+/**
+ * Persists chunk voxels in region files that each hold RegionSize x RegionSize chunks.
+ * A saved chunk is appended and only its header slot is rewritten, a region is compacted once more of it is stale than live.
+ * All file access runs in order on a background pipe, results are delivered on the game thread.
+ */
+class UNNAMEDFACTORYGAME_API FChunkRegionStorage
+{
+public:
+	explicit FChunkRegionStorage( const FString& InDirectory );
+	~FChunkRegionStorage();
+
+	void LoadChunk( const FIntPoint& ChunkCoordinate, TUniqueFunction< void( TOptional< FChunkVoxels >&& ) > OnLoaded );
+	void SaveChunk( const FIntPoint& ChunkCoordinate, FChunkVoxels&& Voxels );
+
+	void Flush();
+
+	static constexpr int32 RegionSize = 16;
+
+private:
+	struct FRegionEntry
+	{
+		int32 Offset = 0;
+		int32 Size   = 0;
+	};
+
+	FString GetRegionFilename( const FIntPoint& RegionCoordinate ) const;
+
+	static FIntPoint GetRegionCoordinate( const FIntPoint& ChunkCoordinate );
+	static int32     GetRegionSlot( const FIntPoint& ChunkCoordinate );
+
+	TOptional< FChunkVoxels > ReadChunk( const FIntPoint& ChunkCoordinate ) const;
+	void                      WriteChunk( const FIntPoint& ChunkCoordinate, const TArray< uint8 >& ChunkData ) const;
+
+	/** Rewrites the region without the data no slot points to anymore */
+	void CompactRegion( const FString& Filename ) const;
+
+	FString Directory;
+
+	UE::Tasks::FPipe Pipe{ UE_SOURCE_LOCATION };
+};
@@ -0,0 +1,270 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkVoxels.h"
+
+FChunkVoxels::FChunkVoxels( const FIntVector& InOrigin, const FIntVector& InExtent )
+{
+	Init( InOrigin, InExtent );
+}
+
+void FChunkVoxels::Init( const FIntVector& InOrigin, const FIntVector& InExtent )
+{
+	check( InExtent.Z <= TNumericLimits< uint16 >::Max() );
+
+	Origin = InOrigin;
+	Extent = InExtent;
+
+	Types.Init( Extent.X * Extent.Y * Extent.Z );
+
+	Spans.Reset( Extent.X * Extent.Y );
+	ColumnOffsets.Reset();
+	ColumnOffsets.SetNumZeroed( Extent.X * Extent.Y + 1 );
+}
+
+void FChunkVoxels::InitColumns( const FIntVector&                                                         InOrigin,
+                                const FIntVector&                                                         InExtent,
+                                const TFunctionRef< void( const FIntPoint&, TArrayView< EVoxelType > ) > FillColumn )
+{
+	Init( InOrigin, InExtent );
+
+	TArray< EVoxelType, TInlineAllocator< 256 > > ColumnTypes;
+	ColumnTypes.SetNumUninitialized( Extent.Z );
+
+	for( int32 ColumnIndex = 0; ColumnIndex < Extent.X * Extent.Y; ++ColumnIndex )
+	{
+		FillColumn( FIntPoint( Origin.X + ColumnIndex / Extent.Y, Origin.Y + ColumnIndex % Extent.Y ), ColumnTypes );
+
+		for( int32 Z = 0; Z < Extent.Z; ++Z )
+			Types.Set( ColumnIndex * Extent.Z + Z, ColumnTypes[ Z ] );
+	}
+
+	RebuildSpans();
+}
+
+void FChunkVoxels::Empty()
+{
+	Origin = FIntVector::ZeroValue;
+	Extent = FIntVector::ZeroValue;
+	Types.Empty();
+	Spans.Empty();
+	ColumnOffsets.Empty();
+}
+
+void FChunkVoxels::SetType( const FIntVector& VoxelCoordinate, const EVoxelType Type )
+{
+	if( !IsInside( VoxelCoordinate ) )
+		return;
+
+	const int32      Index   = ToIndex( VoxelCoordinate );
+	const EVoxelType OldType = Types.Get( Index );
+	if( OldType == Type )
+		return;
+
+	Types.Set( Index, Type );
+	if( ( OldType == EVoxelType::Air ) == ( Type == EVoxelType::Air ) )
+		return;
+
+	const int32  ColumnIndex = ToColumnIndex( FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) );
+	const uint16 Z           = VoxelCoordinate.Z - Origin.Z;
+
+	TArray< FVoxelSpan, TInlineAllocator< 8 > > NewSpans;
+	if( Type == EVoxelType::Air )
+	{
+		for( const FVoxelSpan& Span: GetColumnSpans( ColumnIndex ) )
+		{
+			if( !Span.Contains( Z ) )
+			{
+				NewSpans.Add( Span );
+				continue;
+			}
+
+			if( Span.Bottom < Z )
+				NewSpans.Add( FVoxelSpan{ .Bottom = Span.Bottom, .Top = Z } );
+
+			if( Z + 1 < Span.Top )
+				NewSpans.Add( FVoxelSpan{ .Bottom = static_cast< uint16 >( Z + 1 ), .Top = Span.Top } );
+		}
+	}
+	else
+	{
+		const FVoxelSpan NewSpan{ .Bottom = Z, .Top = static_cast< uint16 >( Z + 1 ) };
+
+		bool Inserted = false;
+		for( const FVoxelSpan& Span: GetColumnSpans( ColumnIndex ) )
+		{
+			if( !Inserted && Span.Bottom > Z )
+			{
+				NewSpans.Add( NewSpan );
+				Inserted = true;
+			}
+
+			NewSpans.Add( Span );
+		}
+
+		if( !Inserted )
+			NewSpans.Add( NewSpan );
+
+		for( int32 i = NewSpans.Num() - 1; i > 0; --i )
+		{
+			if( NewSpans[ i - 1 ].Top != NewSpans[ i ].Bottom )
+				continue;
+
+			NewSpans[ i - 1 ].Top = NewSpans[ i ].Top;
+			NewSpans.RemoveAt( i );
+		}
+	}
+
+	ReplaceColumn( ColumnIndex, NewSpans );
+}
+
+void FChunkVoxels::SetColumn( const int32 Q, const int32 R, const int32 SolidHeight, const EVoxelType Type )
+{
+	const FIntPoint ColumnCoordinate( Q, R );
+	if( !IsColumnInside( ColumnCoordinate ) )
+		return;
+
+	const int32 ColumnIndex = ToColumnIndex( ColumnCoordinate );
+	const int32 SolidVoxels = Type == EVoxelType::Air ? 0 : FMath::Clamp( SolidHeight - Origin.Z, 0, Extent.Z );
+
+	Types.SetRange( ColumnIndex * Extent.Z, SolidVoxels, Type );
+	Types.SetRange( ColumnIndex * Extent.Z + SolidVoxels, Extent.Z - SolidVoxels, EVoxelType::Air );
+
+	if( SolidVoxels == 0 )
+	{
+		ReplaceColumn( ColumnIndex, {} );
+		return;
+	}
+
+	const FVoxelSpan Span{ .Bottom = 0, .Top = static_cast< uint16 >( SolidVoxels ) };
+	ReplaceColumn( ColumnIndex, MakeArrayView( &Span, 1 ) );
+}
+
+void FChunkVoxels::GetColumnTypes( const FIntPoint& ColumnCoordinate, const int32 Bottom, const TArrayView< EVoxelType > OutTypes ) const
+{
+	check( Bottom >= 0 && Bottom + OutTypes.Num() <= Extent.Z );
+
+	if( !IsColumnInside( ColumnCoordinate ) )
+	{
+		for( EVoxelType& Type: OutTypes )
+			Type = EVoxelType::Air;
+
+		return;
+	}
+
+	Types.GetRange( ToColumnIndex( ColumnCoordinate ) * Extent.Z + Bottom, OutTypes );
+}
+
+void FChunkVoxels::SetColumnTypes( const FIntPoint& ColumnCoordinate, const TConstArrayView< EVoxelType > InTypes )
+{
+	check( InTypes.Num() == Extent.Z );
+
+	if( !IsColumnInside( ColumnCoordinate ) )
+		return;
+
+	const int32 ColumnIndex = ToColumnIndex( ColumnCoordinate );
+	for( int32 Z = 0; Z < Extent.Z; ++Z )
+		Types.Set( ColumnIndex * Extent.Z + Z, InTypes[ Z ] );
+
+	RebuildColumnSpans( ColumnIndex );
+}
+
+TConstArrayView< FVoxelSpan > FChunkVoxels::GetColumn( const FIntPoint& ColumnCoordinate ) const
+{
+	if( !IsColumnInside( ColumnCoordinate ) )
+		return {};
+
+	return GetColumnSpans( ToColumnIndex( ColumnCoordinate ) );
+}
+
+int32 FChunkVoxels::GetSurfaceHeight( const FIntPoint& ColumnCoordinate ) const
+{
+	const TConstArrayView< FVoxelSpan > Column = GetColumn( ColumnCoordinate );
+	return Origin.Z + ( Column.IsEmpty() ? 0 : Column.Last().Top );
+}
+
+bool FChunkVoxels::GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const
+{
+	if( !IsInside( VoxelCoordinate ) )
+		return false;
+
+	OutVoxel = FHexagonVoxel( VoxelCoordinate, GetType( VoxelCoordinate ) );
+	return true;
+}
+
+void FChunkVoxels::ReplaceColumn( const int32 ColumnIndex, const TConstArrayView< FVoxelSpan > NewSpans )
+{
+	const int32 Start = ColumnOffsets[ ColumnIndex ];
+	const int32 Delta = NewSpans.Num() - ( ColumnOffsets[ ColumnIndex + 1 ] - Start );
+
+	if( Delta > 0 )
+		Spans.InsertUninitialized( Start, Delta );
+	else if( Delta < 0 )
+		Spans.RemoveAt( Start, -Delta, EAllowShrinking::No );
+
+	FMemory::Memcpy( Spans.GetData() + Start, NewSpans.GetData(), NewSpans.Num() * sizeof( FVoxelSpan ) );
+
+	if( Delta == 0 )
+		return;
+
+	for( int32 i = ColumnIndex + 1; i < ColumnOffsets.Num(); ++i )
+		ColumnOffsets[ i ] += Delta;
+}
+
+template< typename AllocatorType >
+void FChunkVoxels::AppendColumnSpans( const int32 ColumnIndex, TArray< FVoxelSpan, AllocatorType >& OutSpans ) const
+{
+	bool PreviousSolid = false;
+	for( int32 Z = 0; Z < Extent.Z; ++Z )
+	{
+		const bool Solid = Types.Get( ColumnIndex * Extent.Z + Z ) != EVoxelType::Air;
+		if( Solid && !PreviousSolid )
+			OutSpans.Add( FVoxelSpan{ .Bottom = static_cast< uint16 >( Z ), .Top = static_cast< uint16 >( Z + 1 ) } );
+		else if( Solid )
+			OutSpans.Last().Top = Z + 1;
+
+		PreviousSolid = Solid;
+	}
+}
+
+void FChunkVoxels::RebuildColumnSpans( const int32 ColumnIndex )
+{
+	TArray< FVoxelSpan, TInlineAllocator< 8 > > NewSpans;
+	AppendColumnSpans( ColumnIndex, NewSpans );
+	ReplaceColumn( ColumnIndex, NewSpans );
+}
+
+void FChunkVoxels::RebuildSpans()
+{
+	const int32 NumColumns = Extent.X * Extent.Y;
+
+	Spans.Reset( NumColumns );
+	ColumnOffsets.SetNumUninitialized( NumColumns + 1 );
+	ColumnOffsets[ 0 ] = 0;
+
+	for( int32 ColumnIndex = 0; ColumnIndex < NumColumns; ++ColumnIndex )
+	{
+		AppendColumnSpans( ColumnIndex, Spans );
+		ColumnOffsets[ ColumnIndex + 1 ] = Spans.Num();
+	}
+}
+
+FArchive& operator<<( FArchive& Ar, FChunkVoxels& Voxels )
+{
+	Ar << Voxels.Origin;
+	Ar << Voxels.Extent;
+	Ar << Voxels.Types;
+
+	if( !Ar.IsLoading() )
+		return Ar;
+
+	const int32 NumColumns = Voxels.Extent.X * Voxels.Extent.Y;
+	if( Ar.IsError() || Voxels.Extent.GetMin() < 0 || Voxels.Extent.Z > TNumericLimits< uint16 >::Max() || Voxels.Types.Num() != NumColumns * Voxels.Extent.Z )
+	{
+		Ar.SetError();
+		Voxels.Empty();
+		return Ar;
+	}
+
+	Voxels.RebuildSpans();
+	return Ar;
+}
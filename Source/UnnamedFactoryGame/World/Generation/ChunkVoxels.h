@@ -0,0 +1,162 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexagonVoxel.h"
+#include "PackedVoxelTypes.h"
+
+/**
+ * Run of solid voxels in a column, [Bottom, Top) relative to the owning FChunkVoxels origin.
+ */
+struct FVoxelSpan
+{
+	uint16 Bottom = 0;
+	uint16 Top    = 0;
+
+	bool Contains( const int32 Z ) const { return Z >= Bottom && Z < Top; }
+};
+
+/**
+ * Voxel storage for an axis aligned block of hexagon coordinates.
+ * Types are palette packed per voxel, laid out column by column so a (q, r) column is contiguous.
+ * Occupancy is additionally kept as a sorted list of solid spans per column, everything between them is air.
+ * Untouched terrain is a single span per column, edits split and merge spans as needed.
+ */
+struct UNNAMEDFACTORYGAME_API FChunkVoxels
+{
+	FChunkVoxels() = default;
+	FChunkVoxels( const FIntVector& InOrigin, const FIntVector& InExtent );
+
+	void Init( const FIntVector& InOrigin, const FIntVector& InExtent );
+
+	/**
+	 * Init filled column by column in storage order, q major, from FillColumn( ColumnCoordinate, OutTypes ).
+	 * Spans are built in one pass afterwards, setting every column on its own would shift all later columns' spans each time.
+	 */
+	void InitColumns( const FIntVector& InOrigin, const FIntVector& InExtent, TFunctionRef< void( const FIntPoint&, TArrayView< EVoxelType > ) > FillColumn );
+	void Empty();
+
+	const FIntVector& GetOrigin() const { return Origin; }
+	const FIntVector& GetExtent() const { return Extent; }
+
+	bool IsEmpty() const { return ColumnOffsets.IsEmpty(); }
+
+	bool IsInside( const FIntVector& VoxelCoordinate ) const
+	{
+		const FIntVector Local = VoxelCoordinate - Origin;
+		return Local.X >= 0 && Local.Y >= 0 && Local.Z >= 0 && Local.X < Extent.X && Local.Y < Extent.Y && Local.Z < Extent.Z;
+	}
+
+	bool IsColumnInside( const FIntPoint& ColumnCoordinate ) const
+	{
+		const FIntPoint Local = ColumnCoordinate - FIntPoint( Origin.X, Origin.Y );
+		return Local.X >= 0 && Local.Y >= 0 && Local.X < Extent.X && Local.Y < Extent.Y;
+	}
+
+	EVoxelType GetType( const FIntVector& VoxelCoordinate ) const { return IsInside( VoxelCoordinate ) ? Types.Get( ToIndex( VoxelCoordinate ) ) : EVoxelType::Air; }
+	void       SetType( const FIntVector& VoxelCoordinate, EVoxelType Type );
+
+	bool IsSolid( const FIntVector& VoxelCoordinate ) const { return GetType( VoxelCoordinate ) != EVoxelType::Air; }
+
+	void SetColumn( int32 Q, int32 R, int32 SolidHeight, EVoxelType Type );
+
+	void GetColumnTypes( const FIntPoint& ColumnCoordinate, TArrayView< EVoxelType > OutTypes ) const { GetColumnTypes( ColumnCoordinate, 0, OutTypes ); }
+
+	/** Types of the local layers [Bottom, Bottom + OutTypes.Num()) */
+	void GetColumnTypes( const FIntPoint& ColumnCoordinate, int32 Bottom, TArrayView< EVoxelType > OutTypes ) const;
+	void SetColumnTypes( const FIntPoint& ColumnCoordinate, TConstArrayView< EVoxelType > InTypes );
+
+	const FPackedVoxelTypes& GetTypes() const { return Types; }
+
+	TConstArrayView< FVoxelSpan > GetColumn( const FIntPoint& ColumnCoordinate ) const;
+
+	int32 GetSurfaceHeight( const FIntPoint& ColumnCoordinate ) const;
+
+	bool GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const;
+
+	template< typename FunctionType >
+	void ForEachVoxel( FunctionType Function ) const
+	{
+		Types.ForEach(
+			[ this, &Function ]( const int32 Index, const EVoxelType Type )
+			{
+				const int32 ColumnIndex = Index / Extent.Z;
+				Function( FIntVector( Origin.X + ColumnIndex / Extent.Y, Origin.Y + ColumnIndex % Extent.Y, Origin.Z + Index % Extent.Z ), Type );
+			} );
+	}
+
+	template< typename FunctionType >
+	void ForEachColumn( FunctionType Function ) const
+	{
+		for( int32 Q = 0; Q < Extent.X; ++Q )
+		{
+			for( int32 R = 0; R < Extent.Y; ++R )
+			{
+				const int32 ColumnIndex = Q * Extent.Y + R;
+				Function( FIntPoint( Origin.X + Q, Origin.Y + R ), GetColumnSpans( ColumnIndex ) );
+			}
+		}
+	}
+
+	/**
+	 * Calls Function( Bottom, Top ) for every air run of the column within [Bottom, Top), in local z.
+	 * Columns outside the block are treated as air.
+	 */
+	template< typename FunctionType >
+	void ForEachAirRun( const FIntPoint& ColumnCoordinate, const int32 Bottom, const int32 Top, FunctionType Function ) const
+	{
+		int32 Cursor = Bottom;
+		for( const FVoxelSpan& Span: GetColumn( ColumnCoordinate ) )
+		{
+			if( Span.Top <= Cursor )
+				continue;
+
+			if( Span.Bottom >= Top )
+				break;
+
+			if( Span.Bottom > Cursor )
+				Function( Cursor, static_cast< int32 >( Span.Bottom ) );
+
+			Cursor = Span.Top;
+			if( Cursor >= Top )
+				return;
+		}
+
+		if( Cursor < Top )
+			Function( Cursor, Top );
+	}
+
+	SIZE_T GetAllocatedSize() const { return Types.GetAllocatedSize() + Spans.GetAllocatedSize() + ColumnOffsets.GetAllocatedSize(); }
+
+	/**
+	 * Only the origin, extent and packed types are written, spans are rebuilt when loading.
+	 */
+	friend FArchive& operator<<( FArchive& Ar, FChunkVoxels& Voxels );
+
+private:
+	int32 ToColumnIndex( const FIntPoint& ColumnCoordinate ) const { return ( ColumnCoordinate.X - Origin.X ) * Extent.Y + ColumnCoordinate.Y - Origin.Y; }
+	int32 ToIndex( const FIntVector& VoxelCoordinate ) const { return ToColumnIndex( FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) ) * Extent.Z + VoxelCoordinate.Z - Origin.Z; }
+
+	TConstArrayView< FVoxelSpan > GetColumnSpans( const int32 ColumnIndex ) const
+	{
+		return TConstArrayView< FVoxelSpan >( Spans.GetData() + ColumnOffsets[ ColumnIndex ], ColumnOffsets[ ColumnIndex + 1 ] - ColumnOffsets[ ColumnIndex ] );
+	}
+
+	void ReplaceColumn( int32 ColumnIndex, TConstArrayView< FVoxelSpan > NewSpans );
+	void RebuildColumnSpans( int32 ColumnIndex );
+
+	/** Rebuilds every column's spans from the types, appending them in order so the cost is linear in the voxels */
+	void RebuildSpans();
+
+	template< typename AllocatorType >
+	void AppendColumnSpans( int32 ColumnIndex, TArray< FVoxelSpan, AllocatorType >& OutSpans ) const;
+
+	FIntVector Origin = FIntVector::ZeroValue;
+	FIntVector Extent = FIntVector::ZeroValue;
+
+	FPackedVoxelTypes Types;
+
+	TArray< FVoxelSpan > Spans;
+	TArray< int32 >      ColumnOffsets;
+};
@@ -0,0 +1,214 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexagonMeshSceneProxy.h"
+
+#include "Engine/Engine.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialRenderProxy.h"
+#include "PrimitiveSceneInfo.h"
+#include "ProceduralHexagonMeshComponent.h"
+#include "SceneInterface.h"
+
+FHexagonMeshRenderData::FHexagonMeshRenderData( const FHexagonMeshData& MeshData, const ERHIFeatureLevel::Type FeatureLevel )
+	: VertexFactory( FeatureLevel, "FHexagonMeshRenderData" )
+{
+	const int32 NumVertices = MeshData.Vertices.Num();
+
+	VertexBuffers.PositionVertexBuffer.Init( MeshData.Vertices, false );
+	VertexBuffers.StaticMeshVertexBuffer.Init( NumVertices, 1, false );
+	for( int32 i = 0; i < NumVertices; ++i )
+	{
+		const FVector3f TangentZ = MeshData.Normals[ i ].ToFVector3f();
+		const FVector3f TangentX = ( FMath::Abs( TangentZ.Z ) < .9f ? FVector3f::UpVector : FVector3f::ForwardVector ).Cross( TangentZ ).GetSafeNormal();
+		const FVector3f TangentY = TangentZ.Cross( TangentX );
+
+		VertexBuffers.StaticMeshVertexBuffer.SetVertexTangents( i, TangentX, TangentY, TangentZ );
+		VertexBuffers.StaticMeshVertexBuffer.SetVertexUV( i, 0, MeshData.UVs.IsEmpty() ? FVector2f::ZeroVector : FVector2f( MeshData.UVs[ i ] ) );
+	}
+
+	IndexBuffer.SetIndices( MeshData.Triangles, EIndexBufferStride::AutoDetect );
+}
+
+void FHexagonMeshRenderData::InitResources( FRHICommandListBase& RHICmdList )
+{
+	VertexBuffers.PositionVertexBuffer.InitResource( RHICmdList );
+	VertexBuffers.StaticMeshVertexBuffer.InitResource( RHICmdList );
+	IndexBuffer.InitResource( RHICmdList );
+
+	FLocalVertexFactory::FDataType Data;
+	VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer( &VertexFactory, Data );
+	VertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer( &VertexFactory, Data );
+	VertexBuffers.StaticMeshVertexBuffer.BindPackedTexCoordVertexBuffer( &VertexFactory, Data );
+	VertexBuffers.StaticMeshVertexBuffer.BindLightMapVertexBuffer( &VertexFactory, Data, 0 );
+	FColorVertexBuffer::BindDefaultColorVertexBuffer( &VertexFactory, Data, FColorVertexBuffer::NullBindStride::ZeroForDefaultBufferBind );
+
+	VertexFactory.SetData( RHICmdList, Data );
+	VertexFactory.InitResource( RHICmdList );
+}
+
+void FHexagonMeshRenderData::ReleaseResources()
+{
+	VertexFactory.ReleaseResource();
+	IndexBuffer.ReleaseResource();
+	VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+	VertexBuffers.PositionVertexBuffer.ReleaseResource();
+}
+
+SIZE_T FHexagonMeshRenderData::GetAllocatedSize() const
+{
+	return VertexBuffers.PositionVertexBuffer.GetNumVertices() * VertexBuffers.PositionVertexBuffer.GetStride()
+	     + VertexBuffers.StaticMeshVertexBuffer.GetResourceSize() + IndexBuffer.GetIndexDataSize();
+}
+
+FHexagonMeshSceneProxy::FHexagonMeshSceneProxy( const UProceduralHexagonMeshComponent* Component, TArray< TUniquePtr< FHexagonMeshRenderData > >&& InSections )
+	: FPrimitiveSceneProxy( Component ),
+	  Sections( MoveTemp( InSections ) ),
+	  Material( Component->GetMaterial( 0 ) )
+{
+	if( !Material )
+		Material = UMaterial::GetDefaultMaterial( MD_Surface );
+
+	MaterialRelevance = Material->GetRelevance_Concurrent( GetScene().GetShaderPlatform() );
+}
+
+FHexagonMeshSceneProxy::~FHexagonMeshSceneProxy()
+{
+	for( const TUniquePtr< FHexagonMeshRenderData >& Section: Sections )
+	{
+		if( Section )
+			Section->ReleaseResources();
+	}
+}
+
+void FHexagonMeshSceneProxy::SetSections_RenderThread( FRHICommandListBase& RHICmdList, TArray< FSection >&& NewSections )
+{
+	check( IsInRenderingThread() );
+
+	for( FSection& NewSection: NewSections )
+	{
+		if( NewSection.Value )
+			NewSection.Value->InitResources( RHICmdList );
+
+		if( !Sections.IsValidIndex( NewSection.Key ) )
+			Sections.SetNum( NewSection.Key + 1 );
+
+		TUniquePtr< FHexagonMeshRenderData >& Section = Sections[ NewSection.Key ];
+		if( Section )
+			Section->ReleaseResources();
+
+		Section = MoveTemp( NewSection.Value );
+	}
+
+	// The cached draws still point at the released buffers, they are recreated from DrawStaticElements before anything renders them
+	if( FPrimitiveSceneInfo* SceneInfo = GetPrimitiveSceneInfo() )
+		SceneInfo->BeginDeferredUpdateStaticMeshesWithoutVisibilityCheck();
+}
+
+SIZE_T FHexagonMeshSceneProxy::GetTypeHash() const
+{
+	static size_t UniquePointer;
+	return reinterpret_cast< size_t >( &UniquePointer );
+}
+
+void FHexagonMeshSceneProxy::CreateRenderThreadResources( FRHICommandListBase& RHICmdList )
+{
+	for( const TUniquePtr< FHexagonMeshRenderData >& Section: Sections )
+	{
+		if( Section )
+			Section->InitResources( RHICmdList );
+	}
+}
+
+void FHexagonMeshSceneProxy::DrawStaticElements( FStaticPrimitiveDrawInterface* PDI )
+{
+	const FMaterialRenderProxy* MaterialProxy = Material->GetRenderProxy();
+	for( const TUniquePtr< FHexagonMeshRenderData >& Section: Sections )
+	{
+		if( !Section )
+			continue;
+
+		FMeshBatch Mesh;
+		SetMeshBatch( *Section, MaterialProxy, Mesh );
+		PDI->DrawMesh( Mesh, FLT_MAX );
+	}
+}
+
+void FHexagonMeshSceneProxy::GetDynamicMeshElements( const TArray< const FSceneView* >& Views,
+                                                     const FSceneViewFamily&            ViewFamily,
+                                                     const uint32                       VisibilityMap,
+                                                     FMeshElementCollector&             Collector ) const
+{
+	const bool Wireframe = AllowDebugViewmodes() && ViewFamily.EngineShowFlags.Wireframe;
+
+	const FMaterialRenderProxy* MaterialProxy = Material->GetRenderProxy();
+	if( Wireframe && GEngine->WireframeMaterial )
+	{
+		FColoredMaterialRenderProxy* WireframeMaterial = new FColoredMaterialRenderProxy( GEngine->WireframeMaterial->GetRenderProxy(), FLinearColor( 0, .5f, 1 ) );
+		Collector.RegisterOneFrameMaterialProxy( WireframeMaterial );
+		MaterialProxy = WireframeMaterial;
+	}
+
+	for( int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex )
+	{
+		if( !( VisibilityMap & 1 << ViewIndex ) )
+			continue;
+
+		for( const TUniquePtr< FHexagonMeshRenderData >& Section: Sections )
+		{
+			if( !Section )
+				continue;
+
+			FMeshBatch& Mesh = Collector.AllocateMesh();
+			SetMeshBatch( *Section, MaterialProxy, Mesh );
+			Mesh.bWireframe = Wireframe;
+
+			Collector.AddMesh( ViewIndex, Mesh );
+		}
+	}
+}
+
+void FHexagonMeshSceneProxy::SetMeshBatch( const FHexagonMeshRenderData& Section, const FMaterialRenderProxy* MaterialProxy, FMeshBatch& OutMesh ) const
+{
+	OutMesh.VertexFactory              = &Section.VertexFactory;
+	OutMesh.MaterialRenderProxy        = MaterialProxy;
+	OutMesh.ReverseCulling             = IsLocalToWorldDeterminantNegative();
+	OutMesh.Type                       = PT_TriangleList;
+	OutMesh.DepthPriorityGroup         = SDPG_World;
+	OutMesh.CastShadow                 = true;
+	OutMesh.bCanApplyViewModeOverrides = false;
+
+	FMeshBatchElement& BatchElement     = OutMesh.Elements[ 0 ];
+	BatchElement.IndexBuffer            = &Section.IndexBuffer;
+	BatchElement.PrimitiveUniformBuffer = GetUniformBuffer();
+	BatchElement.FirstIndex             = 0;
+	BatchElement.NumPrimitives          = Section.IndexBuffer.GetNumIndices() / 3;
+	BatchElement.MinVertexIndex         = 0;
+	BatchElement.MaxVertexIndex         = Section.VertexBuffers.PositionVertexBuffer.GetNumVertices() - 1;
+}
+
+uint32 FHexagonMeshSceneProxy::GetMemoryFootprint() const
+{
+	SIZE_T Size = sizeof( *this ) + GetAllocatedSize() + Sections.GetAllocatedSize();
+	for( const TUniquePtr< FHexagonMeshRenderData >& Section: Sections )
+	{
+		if( Section )
+			Size += Section->GetAllocatedSize();
+	}
+
+	return static_cast< uint32 >( Size );
+}
+
+FPrimitiveViewRelevance FHexagonMeshSceneProxy::GetViewRelevance( const FSceneView* View ) const
+{
+	FPrimitiveViewRelevance Result;
+	Result.bDrawRelevance        = IsShown( View );
+	Result.bShadowRelevance      = IsShadowCast( View );
+	Result.bDynamicRelevance     = IsRichView( *View->Family );
+	Result.bStaticRelevance      = !Result.bDynamicRelevance;
+	Result.bRenderInMainPass     = ShouldRenderInMainPass();
+	Result.bUsesLightingChannels = GetLightingChannelMask() != GetDefaultLightingChannelMask();
+	Result.bRenderCustomDepth    = ShouldRenderCustomDepth();
+	MaterialRelevance.SetPrimitiveViewRelevance( Result );
+	Result.bVelocityRelevance = DrawsVelocity() && Result.bOpaque && Result.bRenderInMainPass;
+	return Result;
+}
@@ -0,0 +1,71 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocalVertexFactory.h"
+#include "Materials/MaterialRelevance.h"
+#include "PrimitiveSceneProxy.h"
+#include "RawIndexBuffer.h"
+#include "Rendering/StaticMeshVertexBuffer.h"
+#include "StaticMeshResources.h"
+
+class UProceduralHexagonMeshComponent;
+struct FHexagonMeshData;
+
+/**
+ * GPU copy of one hexagon mesh.
+ * Tangent frames are packed to 8 bits per axis, UVs to halfs and indices to 16 bits whenever the mesh allows,
+ * the CPU side is dropped once uploaded and vertex colors fall back to the shared default stream.
+ */
+struct FHexagonMeshRenderData
+{
+	FHexagonMeshRenderData( const FHexagonMeshData& MeshData, ERHIFeatureLevel::Type FeatureLevel );
+
+	void InitResources( FRHICommandListBase& RHICmdList );
+	void ReleaseResources();
+
+	SIZE_T GetAllocatedSize() const;
+
+	FStaticMeshVertexBuffers VertexBuffers;
+	FRawStaticIndexBuffer    IndexBuffer;
+	FLocalVertexFactory      VertexFactory;
+};
+
+class FHexagonMeshSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+	/** Section index and its rebuilt data, null when the section became empty */
+	using FSection = TPair< int32, TUniquePtr< FHexagonMeshRenderData > >;
+
+	FHexagonMeshSceneProxy( const UProceduralHexagonMeshComponent* Component, TArray< TUniquePtr< FHexagonMeshRenderData > >&& InSections );
+	virtual ~FHexagonMeshSceneProxy() override;
+
+	/** Swaps in rebuilt sections while keeping the proxy, its place in the scene and every other section, the cached draws are rebuilt before the next frame */
+	void SetSections_RenderThread( FRHICommandListBase& RHICmdList, TArray< FSection >&& NewSections );
+
+	virtual SIZE_T GetTypeHash() const override;
+	virtual void   CreateRenderThreadResources( FRHICommandListBase& RHICmdList ) override;
+
+	/** Sections are drawn from cached draw commands, they only change when SetSections_RenderThread swaps buffers */
+	virtual void DrawStaticElements( FStaticPrimitiveDrawInterface* PDI ) override;
+
+	/** Only views needing a material override such as wireframe collect the sections every frame */
+	virtual void GetDynamicMeshElements( const TArray< const FSceneView* >& Views,
+	                                     const FSceneViewFamily&            ViewFamily,
+	                                     uint32                             VisibilityMap,
+	                                     FMeshElementCollector&             Collector ) const override;
+
+	virtual FPrimitiveViewRelevance GetViewRelevance( const FSceneView* View ) const override;
+	virtual bool                    CanBeOccluded() const override { return !MaterialRelevance.bDisableDepthTest; }
+	virtual uint32                  GetMemoryFootprint() const override;
+
+private:
+	void SetMeshBatch( const FHexagonMeshRenderData& Section, const FMaterialRenderProxy* MaterialProxy, FMeshBatch& OutMesh ) const;
+
+	/** Null for empty sections */
+	TArray< TUniquePtr< FHexagonMeshRenderData > > Sections;
+
+	UMaterialInterface* Material;
+	FMaterialRelevance  MaterialRelevance;
+};
@@ -2,6 +2,8 @@
 
 #include "HexagonVoxel.h"
 
+#include "ChunkVoxels.h"
+
 FHexagonVoxel::FHexagonVoxel( const FIntVector& Coordinate, const EVoxelType VoxelType )
 {
 	GridLocation = Coordinate;
@@ -46,17 +48,12 @@ FIntVector FHexagonVoxel::WorldToVoxel( const FVector& WorldLocation )
 	return Coordinate;
 }
 
-bool FHexagonVoxel::GetVoxel( const TMap< FIntVector, FHexagonVoxel >& Map, const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel )
+bool FHexagonVoxel::GetVoxel( const FChunkVoxels& Voxels, const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel )
 {
-	const FHexagonVoxel* Voxel = Map.Find( VoxelCoordinate );
-	if( !Voxel )
-		return false;
-
-	OutVoxel = *Voxel;
-	return true;
+	return Voxels.GetVoxel( VoxelCoordinate, OutVoxel );
 }
 
-bool FHexagonVoxel::GetVoxel( const TMap< FIntVector, FHexagonVoxel >& Map, const FVector& WorldLocation, FHexagonVoxel& OutVoxel )
+bool FHexagonVoxel::GetVoxel( const FChunkVoxels& Voxels, const FVector& WorldLocation, FHexagonVoxel& OutVoxel )
 {
-	return GetVoxel( Map, WorldToVoxel( WorldLocation ), OutVoxel );
+	return GetVoxel( Voxels, WorldToVoxel( WorldLocation ), OutVoxel );
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "HexagonVoxel.generated.h"
 
+struct FChunkVoxels;
+
 static constexpr float HexagonRadius = 50;
 static constexpr float HexagonHeight = 100;
 static const float     Root3         = FMath::Sqrt( 3.0f );
@@ -23,6 +25,11 @@ enum class EVoxelType : uint8
 {
 	Air,
 	Ground,
+	Stone,
+	Coal,
+	Iron,
+	Copper,
+	Foundation,
 };
 
 USTRUCT()
@@ -42,6 +49,6 @@ struct FHexagonVoxel
 	static FVector    VoxelToWorld( const FIntVector& VoxelCoordinate ) { return FHexagonVoxel( VoxelCoordinate ).WorldLocation; }
 	static FIntVector WorldToVoxel( const FVector& WorldLocation );
 
-	static bool GetVoxel( const TMap< FIntVector, FHexagonVoxel >& Map, const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel );
-	static bool GetVoxel( const TMap< FIntVector, FHexagonVoxel >& Map, const FVector& WorldLocation, FHexagonVoxel& OutVoxel );
+	static bool GetVoxel( const FChunkVoxels& Voxels, const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel );
+	static bool GetVoxel( const FChunkVoxels& Voxels, const FVector& WorldLocation, FHexagonVoxel& OutVoxel );
 };
\ No newline at end of file
@@ -0,0 +1,160 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NoiseGenerator.h"
+
+namespace
+{
+	constexpr int32 PrimeX = 501125321;
+	constexpr int32 PrimeY = 1136930381;
+
+	constexpr int32 WarpSeedX = 0x5f3759df;
+	constexpr int32 WarpSeedY = 0x2545f491;
+
+	/** Largest magnitude the gradient noise below can reach, used to map it into [-1, 1] */
+	constexpr float GradientScale = 1 / .77f;
+
+	FORCEINLINE VectorRegister4Int Hash( const VectorRegister4Int& X, const VectorRegister4Int& Y, const VectorRegister4Int& Seed )
+	{
+		VectorRegister4Int Result = VectorIntXor( Seed, VectorIntXor( X, Y ) );
+		Result                    = VectorIntMultiply( Result, VectorIntSet1( 0x27d4eb2d ) );
+		return VectorIntXor( Result, VectorShiftRightImmLogical( Result, 15 ) );
+	}
+
+	/** Dot product with one of eight gradients ( +-1, +-0.5 ) or ( +-0.5, +-1 ) picked by the hash bits */
+	FORCEINLINE VectorRegister4Float GradientDot( const VectorRegister4Int& Hash, const VectorRegister4Float& X, const VectorRegister4Float& Y )
+	{
+		const VectorRegister4Int   Zero = VectorIntSet1( 0 );
+		const VectorRegister4Float Swap = VectorCastIntToFloat( VectorIntCompareNEQ( VectorIntAnd( Hash, VectorIntSet1( 4 ) ), Zero ) );
+
+		const VectorRegister4Float U = VectorSelect( Swap, Y, X );
+		const VectorRegister4Float V = VectorMultiply( VectorSelect( Swap, X, Y ), VectorSetFloat1( .5f ) );
+
+		const VectorRegister4Int SignU = VectorShiftLeftImm( VectorIntAnd( Hash, VectorIntSet1( 1 ) ), 31 );
+		const VectorRegister4Int SignV = VectorShiftLeftImm( VectorIntAnd( Hash, VectorIntSet1( 2 ) ), 30 );
+
+		return VectorAdd( VectorCastIntToFloat( VectorIntXor( VectorCastFloatToInt( U ), SignU ) ), VectorCastIntToFloat( VectorIntXor( VectorCastFloatToInt( V ), SignV ) ) );
+	}
+
+	/** Quintic fade 6t^5 - 15t^4 + 10t^3 */
+	FORCEINLINE VectorRegister4Float Fade( const VectorRegister4Float& T )
+	{
+		VectorRegister4Float Result = VectorMultiplyAdd( T, VectorSetFloat1( 6 ), VectorSetFloat1( -15 ) );
+		Result                      = VectorMultiplyAdd( Result, T, VectorSetFloat1( 10 ) );
+		return VectorMultiply( Result, VectorMultiply( T, VectorMultiply( T, T ) ) );
+	}
+
+	FORCEINLINE VectorRegister4Float Lerp( const VectorRegister4Float& A, const VectorRegister4Float& B, const VectorRegister4Float& Alpha )
+	{
+		return VectorMultiplyAdd( VectorSubtract( B, A ), Alpha, A );
+	}
+}
+
+FNoiseGenerator::FNoiseGenerator( const FNoiseSettings& InSettings )
+	: Settings( InSettings )
+{
+	Settings.Octaves = FMath::Max( Settings.Octaves, 1 );
+
+	float Amplitude      = 1;
+	float AmplitudeTotal = 0;
+	for( int32 i = 0; i < Settings.Octaves; ++i )
+	{
+		AmplitudeTotal += Amplitude;
+		Amplitude      *= Settings.Gain;
+	}
+
+	AmplitudeScale = AmplitudeTotal > 0 ? 1 / AmplitudeTotal : 1;
+}
+
+float FNoiseGenerator::Sample( const float X, const float Y ) const
+{
+	float Result[ 4 ];
+	VectorStore( Fractal( VectorSetFloat1( X ), VectorSetFloat1( Y ) ), Result );
+	return Result[ 0 ];
+}
+
+void FNoiseGenerator::GenerateGrid( const FIntPoint& Origin, const FIntPoint& Size, const TArrayView< float > OutValues ) const
+{
+	check( OutValues.Num() == Size.X * Size.Y );
+
+	const VectorRegister4Float Lanes = MakeVectorRegisterFloat( 0.0f, 1.0f, 2.0f, 3.0f );
+
+	for( int32 X = 0; X < Size.X; ++X )
+	{
+		const VectorRegister4Float SampleX = VectorSetFloat1( static_cast< float >( Origin.X + X ) );
+		float*                     Column  = OutValues.GetData() + X * Size.Y;
+
+		for( int32 Y = 0; Y < Size.Y; Y += 4 )
+		{
+			const VectorRegister4Float SampleY = VectorAdd( VectorSetFloat1( static_cast< float >( Origin.Y + Y ) ), Lanes );
+			const VectorRegister4Float Values  = Fractal( SampleX, SampleY );
+
+			if( Y + 4 <= Size.Y )
+			{
+				VectorStore( Values, Column + Y );
+				continue;
+			}
+
+			float Tail[ 4 ];
+			VectorStore( Values, Tail );
+			FMemory::Memcpy( Column + Y, Tail, ( Size.Y - Y ) * sizeof( float ) );
+		}
+	}
+}
+
+VectorRegister4Float FNoiseGenerator::Fractal( VectorRegister4Float X, VectorRegister4Float Y ) const
+{
+	if( Settings.WarpAmplitude != 0 )
+	{
+		const VectorRegister4Float WarpFrequency = VectorSetFloat1( Settings.WarpFrequency );
+		const VectorRegister4Float WarpAmplitude = VectorSetFloat1( Settings.WarpAmplitude );
+		const VectorRegister4Float WarpX         = VectorMultiply( X, WarpFrequency );
+		const VectorRegister4Float WarpY         = VectorMultiply( Y, WarpFrequency );
+
+		const VectorRegister4Float OffsetX = Gradient( WarpX, WarpY, VectorIntSet1( Settings.Seed ^ WarpSeedX ) );
+		const VectorRegister4Float OffsetY = Gradient( WarpX, WarpY, VectorIntSet1( Settings.Seed ^ WarpSeedY ) );
+
+		X = VectorMultiplyAdd( OffsetX, WarpAmplitude, X );
+		Y = VectorMultiplyAdd( OffsetY, WarpAmplitude, Y );
+	}
+
+	VectorRegister4Float Result    = VectorZeroFloat();
+	float                Frequency = Settings.Frequency;
+	float                Amplitude = 1;
+
+	for( int32 i = 0; i < Settings.Octaves; ++i )
+	{
+		const VectorRegister4Float Octave = Gradient( VectorMultiply( X, VectorSetFloat1( Frequency ) ), VectorMultiply( Y, VectorSetFloat1( Frequency ) ), VectorIntSet1( Settings.Seed + i ) );
+		Result                            = VectorMultiplyAdd( Octave, VectorSetFloat1( Amplitude ), Result );
+
+		Frequency *= Settings.Lacunarity;
+		Amplitude *= Settings.Gain;
+	}
+
+	return VectorMultiply( Result, VectorSetFloat1( AmplitudeScale ) );
+}
+
+VectorRegister4Float FNoiseGenerator::Gradient( const VectorRegister4Float& X, const VectorRegister4Float& Y, const VectorRegister4Int& Seed )
+{
+	const VectorRegister4Float FloorX = VectorFloor( X );
+	const VectorRegister4Float FloorY = VectorFloor( Y );
+
+	const VectorRegister4Float X0 = VectorSubtract( X, FloorX );
+	const VectorRegister4Float Y0 = VectorSubtract( Y, FloorY );
+	const VectorRegister4Float X1 = VectorSubtract( X0, VectorOneFloat() );
+	const VectorRegister4Float Y1 = VectorSubtract( Y0, VectorOneFloat() );
+
+	const VectorRegister4Int PrimedX0 = VectorIntMultiply( VectorFloatToInt( FloorX ), VectorIntSet1( PrimeX ) );
+	const VectorRegister4Int PrimedY0 = VectorIntMultiply( VectorFloatToInt( FloorY ), VectorIntSet1( PrimeY ) );
+	const VectorRegister4Int PrimedX1 = VectorIntAdd( PrimedX0, VectorIntSet1( PrimeX ) );
+	const VectorRegister4Int PrimedY1 = VectorIntAdd( PrimedY0, VectorIntSet1( PrimeY ) );
+
+	const VectorRegister4Float Value00 = GradientDot( Hash( PrimedX0, PrimedY0, Seed ), X0, Y0 );
+	const VectorRegister4Float Value10 = GradientDot( Hash( PrimedX1, PrimedY0, Seed ), X1, Y0 );
+	const VectorRegister4Float Value01 = GradientDot( Hash( PrimedX0, PrimedY1, Seed ), X0, Y1 );
+	const VectorRegister4Float Value11 = GradientDot( Hash( PrimedX1, PrimedY1, Seed ), X1, Y1 );
+
+	const VectorRegister4Float FadeX = Fade( X0 );
+	const VectorRegister4Float FadeY = Fade( Y0 );
+
+	return VectorMultiply( Lerp( Lerp( Value00, Value10, FadeX ), Lerp( Value01, Value11, FadeX ), FadeY ), VectorSetFloat1( GradientScale ) );
+}
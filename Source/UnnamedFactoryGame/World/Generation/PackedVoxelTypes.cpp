@@ -0,0 +1,164 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PackedVoxelTypes.h"
+
+void FPackedVoxelTypes::Init( const int32 InNumVoxels, const EVoxelType FillType )
+{
+	NumVoxels    = InNumVoxels;
+	BitsPerVoxel = 1;
+
+	Palette.Reset();
+	Palette.Add( FillType );
+
+	Words.SetNumZeroed( FMath::DivideAndRoundUp( NumVoxels, 64 ) );
+}
+
+void FPackedVoxelTypes::Empty()
+{
+	NumVoxels    = 0;
+	BitsPerVoxel = 1;
+
+	Palette.Empty();
+	Words.Empty();
+}
+
+void FPackedVoxelTypes::Set( const int32 Index, const EVoxelType Type )
+{
+	SetRawIndex( Index, FindOrAddPaletteIndex( Type ) );
+}
+
+void FPackedVoxelTypes::SetRange( int32 Index, int32 Count, const EVoxelType Type )
+{
+	if( Count <= 0 )
+		return;
+
+	const uint64 PaletteIndex = FindOrAddPaletteIndex( Type );
+	const int32  VoxelsInWord = 64 / BitsPerVoxel;
+
+	for( ; Count > 0 && Index % VoxelsInWord != 0; ++Index, --Count )
+		SetRawIndex( Index, PaletteIndex );
+
+	if( Count >= VoxelsInWord )
+	{
+		uint64 Pattern = 0;
+		for( int32 i = 0; i < VoxelsInWord; ++i )
+			Pattern |= PaletteIndex << ( i * BitsPerVoxel );
+
+		for( ; Count >= VoxelsInWord; Index += VoxelsInWord, Count -= VoxelsInWord )
+			Words[ Index / VoxelsInWord ] = Pattern;
+	}
+
+	for( ; Count > 0; ++Index, --Count )
+		SetRawIndex( Index, PaletteIndex );
+}
+
+void FPackedVoxelTypes::GetRange( int32 Index, const TArrayView< EVoxelType > OutTypes ) const
+{
+	const uint64 Mask = GetIndexMask();
+
+	int32  BitIndex = Index * BitsPerVoxel;
+	uint64 Word     = Words[ BitIndex >> 6 ] >> ( BitIndex & 63 );
+
+	for( EVoxelType& Type: OutTypes )
+	{
+		Type      = Palette[ Word & Mask ];
+		BitIndex += BitsPerVoxel;
+
+		if( ( BitIndex & 63 ) == 0 && ( BitIndex >> 6 ) < Words.Num() )
+			Word = Words[ BitIndex >> 6 ];
+		else
+			Word >>= BitsPerVoxel;
+	}
+}
+
+uint64 FPackedVoxelTypes::FindOrAddPaletteIndex( const EVoxelType Type )
+{
+	const int32 ExistingIndex = Palette.Find( Type );
+	if( ExistingIndex != INDEX_NONE )
+		return ExistingIndex;
+
+	const int32 NewIndex = Palette.Add( Type );
+	if( NewIndex > static_cast< int32 >( GetIndexMask() ) )
+		Repack( BitsPerVoxel * 2 );
+
+	return NewIndex;
+}
+
+bool FPackedVoxelTypes::HasValidIndices() const
+{
+	// Every index fits a full palette
+	if( Palette.Num() > static_cast< int32 >( GetIndexMask() ) )
+		return true;
+
+	const uint64 Mask         = GetIndexMask();
+	const uint64 PaletteSize  = Palette.Num();
+	const int32  VoxelsInWord = 64 / BitsPerVoxel;
+
+	int32 Index = 0;
+	for( uint64 Word: Words )
+	{
+		for( int32 i = 0; i < VoxelsInWord && Index < NumVoxels; ++i, ++Index )
+		{
+			if( ( Word & Mask ) >= PaletteSize )
+				return false;
+
+			Word >>= BitsPerVoxel;
+		}
+	}
+
+	return true;
+}
+
+void FPackedVoxelTypes::Repack( const int32 NewBitsPerVoxel )
+{
+	check( NewBitsPerVoxel <= 8 );
+
+	TArray< uint64 > OldWords    = MoveTemp( Words );
+	const int32      OldBits     = BitsPerVoxel;
+	const uint64     OldMask     = GetIndexMask();
+	const int32      VoxelsInOld = 64 / OldBits;
+
+	BitsPerVoxel = NewBitsPerVoxel;
+	Words.SetNumZeroed( FMath::DivideAndRoundUp( NumVoxels * BitsPerVoxel, 64 ) );
+
+	for( int32 Index = 0; Index < NumVoxels; ++Index )
+	{
+		const uint64 OldWord = OldWords[ Index / VoxelsInOld ];
+		SetRawIndex( Index, ( OldWord >> ( ( Index % VoxelsInOld ) * OldBits ) ) & OldMask );
+	}
+}
+
+FArchive& operator<<( FArchive& Ar, FPackedVoxelTypes& Types )
+{
+	Ar << Types.NumVoxels;
+	Ar << Types.BitsPerVoxel;
+
+	int32 PaletteSize = Types.Palette.Num();
+	Ar << PaletteSize;
+
+	if( Ar.IsLoading() )
+	{
+		const bool ValidBits = Types.BitsPerVoxel == 1 || Types.BitsPerVoxel == 2 || Types.BitsPerVoxel == 4 || Types.BitsPerVoxel == 8;
+		if( !ValidBits || Types.NumVoxels < 0 || PaletteSize <= 0 || PaletteSize > ( 1 << Types.BitsPerVoxel ) )
+		{
+			Ar.SetError();
+			Types.Empty();
+			return Ar;
+		}
+
+		Types.Palette.SetNum( PaletteSize );
+	}
+
+	for( EVoxelType& Type: Types.Palette )
+		Ar << reinterpret_cast< uint8& >( Type );
+
+	Ar << Types.Words;
+
+	if( Ar.IsLoading() && ( Types.Words.Num() != FMath::DivideAndRoundUp( Types.NumVoxels * Types.BitsPerVoxel, 64 ) || !Types.HasValidIndices() ) )
+	{
+		Ar.SetError();
+		Types.Empty();
+	}
+
+	return Ar;
+}
@@ -0,0 +1,77 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexagonVoxel.h"
+
+/**
+ * Palette compressed voxel types. Every voxel stores an index into a small per owner palette,
+ * bit packed at 1, 2, 4 or 8 bits per voxel depending on how many distinct types are in use.
+ */
+struct UNNAMEDFACTORYGAME_API FPackedVoxelTypes
+{
+	void Init( int32 InNumVoxels, EVoxelType FillType = EVoxelType::Air );
+	void Empty();
+
+	int32 Num() const { return NumVoxels; }
+	int32 GetBitsPerVoxel() const { return BitsPerVoxel; }
+
+	TConstArrayView< EVoxelType > GetPalette() const { return Palette; }
+
+	EVoxelType Get( const int32 Index ) const
+	{
+		const int32 BitIndex = Index * BitsPerVoxel;
+		return Palette[ ( Words[ BitIndex >> 6 ] >> ( BitIndex & 63 ) ) & GetIndexMask() ];
+	}
+
+	void Set( int32 Index, EVoxelType Type );
+	void SetRange( int32 Index, int32 Count, EVoxelType Type );
+	void GetRange( int32 Index, TArrayView< EVoxelType > OutTypes ) const;
+
+	template< typename FunctionType >
+	void ForEach( FunctionType Function ) const
+	{
+		const uint64 Mask         = GetIndexMask();
+		const int32  VoxelsInWord = 64 / BitsPerVoxel;
+
+		int32 Index = 0;
+		for( uint64 Word: Words )
+		{
+			for( int32 i = 0; i < VoxelsInWord && Index < NumVoxels; ++i )
+			{
+				Function( Index++, Palette[ Word & Mask ] );
+				Word >>= BitsPerVoxel;
+			}
+		}
+	}
+
+	SIZE_T GetAllocatedSize() const { return Palette.GetAllocatedSize() + Words.GetAllocatedSize(); }
+
+	friend FArchive& operator<<( FArchive& Ar, FPackedVoxelTypes& Types );
+
+private:
+	uint64 GetIndexMask() const { return ( static_cast< uint64 >( 1 ) << BitsPerVoxel ) - 1; }
+
+	void SetRawIndex( const int32 Index, const uint64 PaletteIndex )
+	{
+		const int32 BitIndex = Index * BitsPerVoxel;
+		const int32 Shift    = BitIndex & 63;
+
+		uint64& Word = Words[ BitIndex >> 6 ];
+		Word         = ( Word & ~( GetIndexMask() << Shift ) ) | ( PaletteIndex << Shift );
+	}
+
+	uint64 FindOrAddPaletteIndex( EVoxelType Type );
+
+	/** True when every packed index points into the palette, loaded data is not trusted to */
+	bool HasValidIndices() const;
+
+	void Repack( int32 NewBitsPerVoxel );
+
+	TArray< EVoxelType, TInlineAllocator< 2 > > Palette;
+	TArray< uint64 >                            Words;
+
+	int32 NumVoxels    = 0;
+	int32 BitsPerVoxel = 1;
+};
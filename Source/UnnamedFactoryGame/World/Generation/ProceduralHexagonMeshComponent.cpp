@@ -2,371 +2,829 @@
 
 #include "ProceduralHexagonMeshComponent.h"
 
-#include "CompGeom/PolygonTriangulation.h"
-#include "IndexTypes.h"
-#include "UnnamedFactoryGame/World/Generation/Chunk.h"
-
-struct FHexagonVertexKey
+#include "HAL/ThreadSingleton.h"
+#include "HexagonMeshSceneProxy.h"
+#include "Misc/App.h"
+#include "PhysicsEngine/BodySetup.h"
+
+/** Cosine and sine of the hexagon corner at Corner * 60 degrees, also its offset from the center in radii */
+static constexpr float CornerOffsets[ 6 ][ 2 ] = { { 1, 0 }, { .5f, UE_HALF_SQRT_3 }, { -.5f, UE_HALF_SQRT_3 }, { -1, 0 }, { -.5f, -UE_HALF_SQRT_3 }, { .5f, -UE_HALF_SQRT_3 } };
+
+/** Outward normal of the side between the corners Side - 1 and Side, at Side * 60 - 30 degrees */
+static constexpr float SideNormals[ 6 ][ 2 ] = { { UE_HALF_SQRT_3, -.5f }, { UE_HALF_SQRT_3, .5f }, { 0, 1 }, { -UE_HALF_SQRT_3, .5f }, { -UE_HALF_SQRT_3, -.5f }, { 0, -1 } };
+
+/**
+ * Occupancy of one layer over its bounding box, so membership tests are a bit lookup.
+ * Hexagon corners get dense ids on the same box: every corner is owned by the hexagon it lies at 0 or 60 degrees of.
+ */
+struct FHexagonLayerGrid
 {
-	TArray< FIntPoint > Coordinates;
+	void Init( const TConstArrayView< FIntPoint > Coordinates )
+	{
+		FIntPoint Max = Coordinates[ 0 ];
+		Min           = Coordinates[ 0 ];
+		for( const FIntPoint& Coordinate: Coordinates )
+		{
+			Min = Min.ComponentMin( Coordinate );
+			Max = Max.ComponentMax( Coordinate );
+		}
 
-	FHexagonVertexKey() { Coordinates.AddZeroed( 3 ); }
-	FHexagonVertexKey( const FIntPoint& A, const FIntPoint& B, const FIntPoint& C )
+		Size = Max - Min + FIntPoint( 1 );
+		Cells.Reset();
+		Cells.Add( false, Size.X * Size.Y );
+		for( const FIntPoint& Coordinate: Coordinates )
+			Cells[ ToIndex( Coordinate ) ] = true;
+	}
+
+	bool Contains( const FIntPoint& Coordinate ) const
 	{
-		Coordinates.Add( A );
-		Coordinates.Add( B );
-		Coordinates.Add( C );
-		Coordinates.Sort( []( const FIntPoint& Left, const FIntPoint& Right ) { return Left.X < Right.X || ( Left.X == Right.X && Left.Y < Right.Y ); } );
+		const FIntPoint Local = Coordinate - Min;
+		return Local.X >= 0 && Local.Y >= 0 && Local.X < Size.X && Local.Y < Size.Y && Cells[ ToIndex( Coordinate ) ];
 	}
 
-	bool operator==( const FHexagonVertexKey& Other ) const { return Coordinates == Other.Coordinates; }
+	int32     ToIndex( const FIntPoint& Coordinate ) const { return ( Coordinate.Y - Min.Y ) * Size.X + Coordinate.X - Min.X; }
+	FIntPoint ToCoordinate( const int32 Index ) const { return Min + FIntPoint( Index % Size.X, Index / Size.X ); }
+
+	/** Corner owners reach one hexagon below the box in q and one below and above it in r */
+	int32 GetNumCorners() const { return ( Size.X + 1 ) * ( Size.Y + 2 ) * 2; }
 
-	friend uint32 GetTypeHash( const FHexagonVertexKey& Key )
+	/** Id of the corner at Corner * 60 degrees of the hexagon, between CoordinateDirections[ Corner ] and the next direction */
+	int32 ToCornerId( const FIntPoint& Coordinate, const int32 Corner ) const
 	{
-		return HashCombine( HashCombine( GetTypeHash( Key.Coordinates[ 0 ] ), GetTypeHash( Key.Coordinates[ 1 ] ) ), GetTypeHash( Key.Coordinates[ 2 ] ) );
+		static constexpr int32 CornerOwners[ 6 ][ 3 ] = { { 0, 0, 0 }, { 0, 0, 1 }, { -1, 1, 0 }, { -1, 0, 1 }, { -1, 0, 0 }, { 0, -1, 1 } };
+
+		const int32 Q = Coordinate.X + CornerOwners[ Corner ][ 0 ] - Min.X + 1;
+		const int32 R = Coordinate.Y + CornerOwners[ Corner ][ 1 ] - Min.Y + 1;
+		return ( R * ( Size.X + 1 ) + Q ) * 2 + CornerOwners[ Corner ][ 2 ];
 	}
-};
 
-void UProceduralHexagonMeshComponent::Generate( const TMap< FIntVector, FHexagonVoxel >& HexagonVoxels,
-                                                const bool                               GenerateCollision,
-                                                FSkipGenerationDelegate                  SkipGenerationDelegate )
-{
-	TMap< int32, TArray< FIntPoint > >  TopVisibleVoxels;
-	TMap< int32, TArray< FIntPoint > >  BottomVisibleVoxels;
-	TMap< FIntVector, TArray< int32 > > SideVisibleVoxels;
+	FIntPoint ToCornerOwner( const int32 CornerId ) const
+	{
+		const int32 Owner = CornerId / 2;
+		return Min - FIntPoint( 1 ) + FIntPoint( Owner % ( Size.X + 1 ), Owner / ( Size.X + 1 ) );
+	}
 
-	for( const TPair< FIntVector, FHexagonVoxel >& HexagonTile: HexagonVoxels )
+	FVector ToCornerLocation( const int32 CornerId, const int32 Z ) const
 	{
-		const FHexagonVoxel& Voxel           = HexagonTile.Value;
-		const FIntVector&    VoxelCoordinate = Voxel.GridLocation;
+		const FIntPoint Owner  = ToCornerOwner( CornerId );
+		const float*    Offset = CornerOffsets[ CornerId % 2 ];
+		return FHexagonVoxel::VoxelToWorld( FIntVector( Owner.X, Owner.Y, Z ) ) + FVector( Offset[ 0 ], Offset[ 1 ], 0 ) * HexagonRadius;
+	}
 
-		if( Voxel.Type == EVoxelType::Air )
-			continue;
+	/** Exact corner position in half radii along x and half hexagon widths along y */
+	FIntPoint ToCornerLattice( const int32 CornerId ) const
+	{
+		const FIntPoint Owner = ToCornerOwner( CornerId );
+		const int32     Slot  = CornerId % 2;
+		return FIntPoint( 3 * Owner.X + 2 - Slot, 2 * Owner.Y + Owner.X + Slot );
+	}
 
-		if( SkipGenerationDelegate.IsBound() && SkipGenerationDelegate.Execute( Voxel ) )
-			continue;
+	FIntPoint   Min  = FIntPoint::ZeroValue;
+	FIntPoint   Size = FIntPoint::ZeroValue;
+	TBitArray<> Cells;
+};
 
-		FHexagonVoxel TopVoxel;
-		if( !FHexagonVoxel::GetVoxel( HexagonVoxels, VoxelCoordinate + FIntVector( 0, 0, 1 ), TopVoxel ) || TopVoxel.Type == EVoxelType::Air )
-			TopVisibleVoxels.FindOrAdd( VoxelCoordinate.Z ).Add( FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) );
+/**
+ * Layer outline edge between two corners on neighbouring vertical lines, Left being the one with the smaller x.
+ */
+struct FHexagonOutlineEdge
+{
+	int32 Left;
+	int32 Right;
 
-		FHexagonVoxel BottomVoxel;
-		if( !FHexagonVoxel::GetVoxel( HexagonVoxels, VoxelCoordinate - FIntVector( 0, 0, 1 ), BottomVoxel ) || BottomVoxel.Type == EVoxelType::Air )
-			BottomVisibleVoxels.FindOrAdd( VoxelCoordinate.Z ).Add( FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) );
+	/** Lattice x of the left corner, identifies the slab the edge crosses */
+	int32 Slab;
 
-		for( int32 i = 0; i < 6; ++i )
-		{
-			const FIntPoint  Direction      = CoordinateDirections[ i ];
-			const FIntVector SideCoordinate = { VoxelCoordinate.X + Direction.X, VoxelCoordinate.Y + Direction.Y, VoxelCoordinate.Z };
+	/** Sum of both lattice y values, orders the edges inside a slab */
+	int32 Height;
+};
 
-			FHexagonVoxel SideVoxel;
-			if( !FHexagonVoxel::GetVoxel( HexagonVoxels, SideCoordinate, SideVoxel ) || SideVoxel.Type == EVoxelType::Air )
-				SideVisibleVoxels.FindOrAdd( FIntVector( VoxelCoordinate.X, VoxelCoordinate.Y, i ) ).Add( VoxelCoordinate.Z );
-		}
+/**
+ * Meshing buffers owned by each thread, reset instead of freed between chunks.
+ * Once they have grown to the largest chunk seen, building a mesh allocates nothing but its output.
+ */
+struct FHexagonMeshScratch : TThreadSingleton< FHexagonMeshScratch >
+{
+	void Reset( const int32 NumLayers )
+	{
+		TopLayers.SetNum( FMath::Max( TopLayers.Num(), NumLayers ) );
+		BottomLayers.SetNum( FMath::Max( BottomLayers.Num(), NumLayers ) );
+
+		for( TArray< FIntPoint >& Layer: TopLayers )
+			Layer.Reset();
+		for( TArray< FIntPoint >& Layer: BottomLayers )
+			Layer.Reset();
 	}
 
-	TArray< FVector >   Vertices;
-	TArray< int32 >     Triangles;
-	TArray< FVector >   Normals;
-	TArray< FVector2D > UVs;
+	/** Visible faces per layer, indexed by height above the voxel origin */
+	TArray< TArray< FIntPoint > > TopLayers;
+	TArray< TArray< FIntPoint > > BottomLayers;
+
+	FHexagonLayerGrid Layer;
 
-	GenerateRegions( TopVisibleVoxels, true, Vertices, Triangles, Normals, UVs );
-	GenerateRegions( BottomVisibleVoxels, false, Vertices, Triangles, Normals, UVs );
-	GenerateRegions( SideVisibleVoxels, Vertices, Triangles, Normals, UVs );
+	TArray< FHexagonOutlineEdge > Edges;
 
+	/** Outline corners sorted by their vertical line and then bottom to top */
+	TArray< int32 > OutlineCorners;
+
+	/** Position in OutlineCorners and output vertex by corner id, INDEX_NONE when unused */
+	TArray< int32 > CornerOrder;
+	TArray< int32 > CornerVertices;
+};
+
+template< typename PolicyType >
+void UProceduralHexagonMeshComponent::Generate( const FChunkVoxels& HexagonVoxels, const bool GenerateCollision )
+{
 	AsyncTask( ENamedThreads::GameThread,
-	           [ this, Vertices, Triangles, Normals, UVs, GenerateCollision ]
+	           [ WeakThis = TWeakObjectPtr< UProceduralHexagonMeshComponent >( this ), MeshData = BuildMesh< PolicyType >( HexagonVoxels ), GenerateCollision ]() mutable
 	           {
-				   if( Vertices.IsEmpty() )
-					   return;
-
-				   const TArray< FLinearColor >     VertexColors;
-				   const TArray< FProcMeshTangent > Tangents;
-				   CreateMeshSection_LinearColor( 0, Vertices, Triangles, Normals, UVs, VertexColors, Tangents, GenerateCollision );
+				   if( UProceduralHexagonMeshComponent* This = WeakThis.Get() )
+					   This->ApplyMesh( MoveTemp( MeshData ), GenerateCollision );
 			   } );
 }
 
-void UProceduralHexagonMeshComponent::GenerateRegions( TMap< int32, TArray< FIntPoint > >& VisibleVoxelCoordinates,
-                                                       const bool                          IsTop,
-                                                       TArray< FVector >&                  OutVertices,
-                                                       TArray< int32 >&                    OutTriangles,
-                                                       TArray< FVector >&                  OutNormals,
-                                                       TArray< FVector2D >&                OutUVs ) const
+template< typename PolicyType >
+FHexagonMeshData UProceduralHexagonMeshComponent::BuildMesh( const FChunkVoxels& HexagonVoxels, const int32 Bottom, const int32 Top )
 {
-	for( TPair< int32, TArray< FIntPoint > >& VoxelPlane: VisibleVoxelCoordinates )
-	{
-		TArray< FIntPoint >& Coordinates = VoxelPlane.Value;
+	FHexagonMeshData MeshData;
+	BuildMesh< PolicyType >( HexagonVoxels, MeshData, Bottom, Top );
+	return MeshData;
+}
 
-		while( !Coordinates.IsEmpty() )
-		{
-			TArray< FIntPoint > Region;
-			TArray< FIntPoint > Queue;
+template< typename PolicyType >
+void UProceduralHexagonMeshComponent::BuildMesh( const FChunkVoxels& HexagonVoxels, FHexagonMeshData& MeshData, const int32 Bottom, int32 Top )
+{
+	Top = FMath::Min( Top, HexagonVoxels.GetExtent().Z );
+
+	FHexagonMeshScratch& Scratch = FHexagonMeshScratch::Get();
+	Scratch.Reset( HexagonVoxels.GetExtent().Z );
 
-			const FIntPoint Start = *Coordinates.begin();
-			Coordinates.RemoveAt( 0 );
-			Region.Add( Start );
-			Queue.Add( Start );
+	const FIntVector& Origin  = HexagonVoxels.GetOrigin();
+	const FIntVector& Extent  = HexagonVoxels.GetExtent();
+	const FIntPoint   Min     = FIntPoint( Origin.X, Origin.Y );
+	const FIntPoint   Max     = Min + FIntPoint( Extent.X - 1, Extent.Y - 1 );
+	const int32       OriginZ = Origin.Z;
 
-			while( !Queue.IsEmpty() )
+	HexagonVoxels.ForEachColumn(
+		[ & ]( const FIntPoint& ColumnCoordinate, const TConstArrayView< FVoxelSpan > Column )
+		{
+			if constexpr( PolicyType::IsPadded )
 			{
-				const FIntPoint Current = Queue.Pop();
+				if( ColumnCoordinate.X == Min.X || ColumnCoordinate.Y == Min.Y || ColumnCoordinate.X == Max.X || ColumnCoordinate.Y == Max.Y )
+					return;
+			}
 
-				for( const FIntPoint& Direction: CoordinateDirections )
-				{
-					FIntPoint Neighbor = Current + Direction;
-					if( !Coordinates.Contains( Neighbor ) )
-						continue;
+			for( int32 SpanIndex = 0; SpanIndex < Column.Num(); ++SpanIndex )
+			{
+				const FVoxelSpan& Span = Column[ SpanIndex ];
+				if( Span.Top <= Bottom || Span.Bottom >= Top )
+					continue;
+
+				const bool TopCovered    = Column.IsValidIndex( SpanIndex + 1 ) && Column[ SpanIndex + 1 ].Bottom == Span.Top;
+				const bool BottomCovered = SpanIndex > 0 && Column[ SpanIndex - 1 ].Top == Span.Bottom;
+
+				if( !TopCovered && Span.Top > Bottom && Span.Top <= Top )
+					Scratch.TopLayers[ Span.Top - 1 ].Add( ColumnCoordinate );
 
-					Coordinates.Remove( Neighbor );
-					Region.Add( Neighbor );
-					Queue.Add( Neighbor );
+				if( !BottomCovered && Span.Bottom >= Bottom && Span.Bottom < Top )
+					Scratch.BottomLayers[ Span.Bottom ].Add( ColumnCoordinate );
+
+				const int32 SideBottom = FMath::Max< int32 >( Span.Bottom, Bottom );
+				const int32 SideTop    = FMath::Min< int32 >( Span.Top, Top );
+				for( int32 i = 0; i < 6; ++i )
+				{
+					const FIntVector SideCoordinate( ColumnCoordinate.X, ColumnCoordinate.Y, i );
+					HexagonVoxels.ForEachAirRun( ColumnCoordinate + CoordinateDirections[ i ],
+					                             SideBottom,
+					                             SideTop,
+					                             [ & ]( const int32 AirBottom, const int32 AirTop )
+					                             { GeneratePolygon< PolicyType >( SideCoordinate, OriginZ + AirBottom, OriginZ + AirTop, MeshData ); } );
 				}
 			}
+		} );
+
+	GenerateLayers< PolicyType >( Scratch, Scratch.TopLayers, OriginZ, true, MeshData );
+	GenerateLayers< PolicyType >( Scratch, Scratch.BottomLayers, OriginZ, false, MeshData );
+}
+
+FHexagonMeshData UProceduralHexagonMeshComponent::BuildLodMesh( const FChunkVoxels& HexagonVoxels, const int32 Step )
+{
+	FHexagonMeshData MeshData;
 
-			GeneratePolygon( VoxelPlane.Key, Region, IsTop, OutVertices, OutTriangles, OutNormals, OutUVs );
+	const FIntVector& Origin = HexagonVoxels.GetOrigin();
+	const FIntVector& Extent = HexagonVoxels.GetExtent();
+	if( Step <= 0 || Extent.X < 2 || Extent.Y < 2 )
+		return MeshData;
+
+	// The last stored column is always sampled so the surface reaches as far as the full detail mesh
+	const auto MakeSamples = [ Step ]( const int32 First, const int32 Num )
+	{
+		TArray< int32 > Samples;
+		for( int32 i = 0; i < Num - 1; i += Step )
+			Samples.Add( First + i );
+
+		Samples.Add( First + Num - 1 );
+		return Samples;
+	};
+
+	const TArray< int32 > QSamples = MakeSamples( Origin.X, Extent.X );
+	const TArray< int32 > RSamples = MakeSamples( Origin.Y, Extent.Y );
+	const int32           NumQ     = QSamples.Num();
+	const int32           NumR     = RSamples.Num();
+
+	TArray< FVector3f >&     Vertices  = MeshData.Vertices;
+	TArray< uint32 >&        Triangles = MeshData.Triangles;
+	TArray< FPackedNormal >& Normals   = MeshData.Normals;
+
+	const int32 NumSkirtEdges = 2 * ( NumQ + NumR - 2 );
+	Vertices.Reserve( NumQ * NumR + NumSkirtEdges * 4 );
+	Normals.Reserve( NumQ * NumR + NumSkirtEdges * 4 );
+	Triangles.Reserve( ( ( NumQ - 1 ) * ( NumR - 1 ) + NumSkirtEdges ) * 6 );
+
+	int32 MinHeight = TNumericLimits< int32 >::Max();
+	for( const int32 Q: QSamples )
+	{
+		for( const int32 R: RSamples )
+		{
+			const int32 Height = HexagonVoxels.GetSurfaceHeight( FIntPoint( Q, R ) );
+			MinHeight          = FMath::Min( MinHeight, Height );
+
+			// Every vertex is a column center
+			Vertices.Add( FVector3f( FHexagonVoxel::VoxelToWorld( FIntVector( Q, R, Height ) ) ) );
+		}
+	}
+
+	TArray< FVector3f > SurfaceNormals;
+	SurfaceNormals.SetNumZeroed( Vertices.Num() );
+
+	const auto ToIndex = [ NumR ]( const int32 Q, const int32 R ) { return Q * NumR + R; };
+
+	const auto AddTriangle = [ & ]( const int32 A, const int32 B, const int32 C )
+	{
+		Triangles.Add( A );
+		Triangles.Add( B );
+		Triangles.Add( C );
+
+		const FVector3f Normal = FVector3f::CrossProduct( Vertices[ B ] - Vertices[ A ], Vertices[ C ] - Vertices[ A ] );
+		SurfaceNormals[ A ]    += Normal;
+		SurfaceNormals[ B ]    += Normal;
+		SurfaceNormals[ C ]    += Normal;
+	};
+
+	// Each cell is a rhombus of the axial grid, split along its shorter diagonal
+	for( int32 Q = 0; Q < NumQ - 1; ++Q )
+	{
+		for( int32 R = 0; R < NumR - 1; ++R )
+		{
+			AddTriangle( ToIndex( Q, R ), ToIndex( Q + 1, R ), ToIndex( Q, R + 1 ) );
+			AddTriangle( ToIndex( Q + 1, R ), ToIndex( Q + 1, R + 1 ), ToIndex( Q, R + 1 ) );
 		}
 	}
+
+	for( const FVector3f& Normal: SurfaceNormals )
+		Normals.Add( FPackedNormal( Normal.GetSafeNormal( UE_SMALL_NUMBER, FVector3f::UpVector ) ) );
+
+	// Walk the border counter clockwise so every skirt quad faces outwards
+	TArray< int32 > Border;
+	Border.Reserve( NumSkirtEdges );
+	for( int32 Q = 0; Q < NumQ - 1; ++Q )
+		Border.Add( ToIndex( Q, 0 ) );
+	for( int32 R = 0; R < NumR - 1; ++R )
+		Border.Add( ToIndex( NumQ - 1, R ) );
+	for( int32 Q = NumQ - 1; Q > 0; --Q )
+		Border.Add( ToIndex( Q, NumR - 1 ) );
+	for( int32 R = NumR - 1; R > 0; --R )
+		Border.Add( ToIndex( 0, R ) );
+
+	const float SkirtBottom = ( MinHeight - 1 ) * HexagonHeight;
+	for( int32 i = 0; i < Border.Num(); ++i )
+	{
+		const FVector3f TopLeft     = Vertices[ Border[ i ] ];
+		const FVector3f TopRight    = Vertices[ Border[ ( i + 1 ) % Border.Num() ] ];
+		const FVector3f BottomLeft  = FVector3f( TopLeft.X, TopLeft.Y, SkirtBottom );
+		const FVector3f BottomRight = FVector3f( TopRight.X, TopRight.Y, SkirtBottom );
+
+		const int32 Index = Vertices.Num();
+		Vertices.Add( TopLeft );
+		Vertices.Add( TopRight );
+		Vertices.Add( BottomLeft );
+		Vertices.Add( BottomRight );
+
+		Triangles.Add( Index );
+		Triangles.Add( Index + 1 );
+		Triangles.Add( Index + 2 );
+
+		Triangles.Add( Index + 1 );
+		Triangles.Add( Index + 3 );
+		Triangles.Add( Index + 2 );
+
+		const FVector3f Edge   = TopRight - TopLeft;
+		const FVector3f Normal = FVector3f( Edge.Y, -Edge.X, 0 ).GetSafeNormal();
+		for( int32 j = 0; j < 4; ++j )
+			Normals.Add( FPackedNormal( Normal ) );
+	}
+
+	return MeshData;
 }
 
-void UProceduralHexagonMeshComponent::GenerateRegions( TMap< FIntVector, TArray< int32 > >& VisibleVoxelCoordinates,
-                                                       TArray< FVector >&                   OutVertices,
-                                                       TArray< int32 >&                     OutTriangles,
-                                                       TArray< FVector >&                   OutNormals,
-                                                       TArray< FVector2D >&                 OutUVs ) const
+TArray< FKBoxElem > UProceduralHexagonMeshComponent::BuildColumnBoxes( const FChunkVoxels& HexagonVoxels )
 {
-	for( TPair< FIntVector, TArray< int32 > >& VoxelPlane: VisibleVoxelCoordinates )
+	TArray< FKBoxElem > Boxes;
+
+	const FIntVector& Origin = HexagonVoxels.GetOrigin();
+	const FIntVector& Extent = HexagonVoxels.GetExtent();
+
+	const float BoxLengthX = HexagonRadius * 1.5f;
+	const float BoxLengthY = HexagonRadius * Root3;
+
+	/** Span shared by the columns from StartR up to the current one */
+	struct FColumnRun
 	{
-		TArray< int32 >& Heights = VoxelPlane.Value;
+		FVoxelSpan Span;
+		int32      StartR;
+	};
 
-		while( !Heights.IsEmpty() )
-		{
-			TArray< int32 > Region;
-			TArray< int32 > Queue;
+	TArray< FColumnRun > Runs;
+	TArray< FColumnRun > NextRuns;
 
-			const int32 Start = *Heights.begin();
-			Heights.RemoveAt( 0 );
-			Region.Add( Start );
-			Queue.Add( Start );
+	for( int32 Q = Origin.X; Q < Origin.X + Extent.X; ++Q )
+	{
+		Runs.Reset();
+		for( int32 R = Origin.Y; R <= Origin.Y + Extent.Y; ++R )
+		{
+			NextRuns.Reset();
+			if( R < Origin.Y + Extent.Y )
+			{
+				for( const FVoxelSpan& Span: HexagonVoxels.GetColumn( FIntPoint( Q, R ) ) )
+				{
+					const FColumnRun* Run = Runs.FindByPredicate( [ &Span ]( const FColumnRun& Other ) { return Other.Span.Bottom == Span.Bottom && Other.Span.Top == Span.Top; } );
+					NextRuns.Add( FColumnRun{ .Span = Span, .StartR = Run ? Run->StartR : R } );
+				}
+			}
 
-			while( !Queue.IsEmpty() )
+			for( const FColumnRun& Run: Runs )
 			{
-				const int32 Current = Queue.Pop();
+				if( NextRuns.ContainsByPredicate( [ &Run ]( const FColumnRun& Other ) { return Other.StartR == Run.StartR && Other.Span.Bottom == Run.Span.Bottom; } ) )
+					continue;
 
-				for( const int32 Direction: { 1, -1 } )
-				{
-					int32 Neighbor = Current + Direction;
-					if( !Heights.Contains( Neighbor ) )
-						continue;
+				const FVector Bottom = FHexagonVoxel::VoxelToWorld( FIntVector( Q, Run.StartR, Origin.Z + Run.Span.Bottom ) );
+				const FVector Top    = FHexagonVoxel::VoxelToWorld( FIntVector( Q, R - 1, Origin.Z + Run.Span.Top ) );
 
-					Heights.Remove( Neighbor );
-					Region.Add( Neighbor );
-					Queue.Add( Neighbor );
-				}
+				FKBoxElem& Box = Boxes.Emplace_GetRef( BoxLengthX, BoxLengthY * ( R - Run.StartR ), HexagonHeight * ( Run.Span.Top - Run.Span.Bottom ) );
+				Box.Center     = ( Bottom + Top ) / 2;
 			}
 
-			GeneratePolygon( VoxelPlane.Key, Region, OutVertices, OutTriangles, OutNormals, OutUVs );
+			Swap( Runs, NextRuns );
 		}
 	}
+
+	return Boxes;
 }
 
-void UProceduralHexagonMeshComponent::GeneratePolygon( const int32          PolygonHeight,
-                                                       TArray< FIntPoint >& Region,
-                                                       const bool           IsTop,
-                                                       TArray< FVector >&   OutVertices,
-                                                       TArray< int32 >&     OutTriangles,
-                                                       TArray< FVector >&   OutNormals,
-                                                       TArray< FVector2D >& OutUVs ) const
+void UProceduralHexagonMeshComponent::ApplyMesh( FHexagonMeshData&& MeshData, const bool GenerateCollision )
 {
-	if( Region.IsEmpty() )
-		return;
+	TArray< FHexagonMeshData > NewSections;
+	NewSections.Add( MoveTemp( MeshData ) );
+	ApplySections( MoveTemp( NewSections ), MAX_uint32 );
 
-	TMap< FHexagonVertexKey, FHexagonVertexKey > EdgeConnections;
-	TMap< FHexagonVertexKey, FVector >           KeyToLocation;
+	SetCollisionType( GenerateCollision ? EHexagonCollisionType::Mesh : EHexagonCollisionType::None );
+}
+
+void UProceduralHexagonMeshComponent::ApplySections( TArray< FHexagonMeshData >&& NewSections, const uint32 SectionMask )
+{
+	const int32 NumSections = FMath::Max( Sections.Num(), NewSections.Num() );
+	check( NumSections <= 32 );
 
-	for( const FIntPoint& VoxelCoordinate: Region )
+	Sections.SetNum( NumSections );
+	SectionBounds.SetNum( NumSections );
+
+	FHexagonMeshSceneProxy*                    Proxy = static_cast< FHexagonMeshSceneProxy* >( SceneProxy );
+	TArray< FHexagonMeshSceneProxy::FSection > ProxySections;
+
+	FBox3f Bounds( ForceInit );
+	for( int32 i = 0; i < NumSections; ++i )
 	{
-		for( int32 i = 0; i < 6; ++i )
+		if( SectionMask & 1u << i )
 		{
-			const FIntPoint& Neighbor = VoxelCoordinate + CoordinateDirections[ i ];
-			if( Region.Contains( Neighbor ) )
-				continue;
+			Sections[ i ]      = NewSections.IsValidIndex( i ) ? MoveTemp( NewSections[ i ] ) : FHexagonMeshData();
+			SectionBounds[ i ] = Sections[ i ].IsEmpty() ? FBox3f( ForceInit ) : FBox3f( Sections[ i ].Vertices );
 
-			const FIntPoint& ThirdHexagon1 = VoxelCoordinate + CoordinateDirections[ ( i + 5 ) % 6 ];
-			const FIntPoint& ThirdHexagon2 = VoxelCoordinate + CoordinateDirections[ ( i + 1 ) % 6 ];
+			if( Proxy )
+			{
+				TUniquePtr< FHexagonMeshRenderData > RenderData;
+				if( !Sections[ i ].IsEmpty() )
+					RenderData = MakeUnique< FHexagonMeshRenderData >( Sections[ i ], GetScene()->GetFeatureLevel() );
 
-			const FHexagonVertexKey Key1( VoxelCoordinate, Neighbor, ThirdHexagon1 );
-			const FHexagonVertexKey Key2( VoxelCoordinate, Neighbor, ThirdHexagon2 );
+				ProxySections.Emplace( i, MoveTemp( RenderData ) );
+			}
+		}
 
-			EdgeConnections.Add( Key1, Key2 );
+		Bounds += SectionBounds[ i ];
+	}
 
-			const FVector Center1  = FHexagonVoxel( FIntVector( VoxelCoordinate.X, VoxelCoordinate.Y, PolygonHeight + IsTop ) ).WorldLocation;
-			const FVector Center2  = FHexagonVoxel( FIntVector( Neighbor.X, Neighbor.Y, PolygonHeight + IsTop ) ).WorldLocation;
-			const FVector Center31 = FHexagonVoxel( FIntVector( ThirdHexagon1.X, ThirdHexagon1.Y, PolygonHeight + IsTop ) ).WorldLocation;
-			const FVector Center32 = FHexagonVoxel( FIntVector( ThirdHexagon2.X, ThirdHexagon2.Y, PolygonHeight + IsTop ) ).WorldLocation;
+	LocalBounds = Bounds.IsValid ? FBoxSphereBounds( FBox( Bounds ) ) : FBoxSphereBounds( ForceInitToZero );
 
-			const FVector Corner1 = ( Center1 + Center2 + Center31 ) / 3;
-			const FVector Corner2 = ( Center1 + Center2 + Center32 ) / 3;
+	if( Proxy && !IsMeshEmpty() )
+	{
+		ENQUEUE_RENDER_COMMAND( UpdateHexagonMesh )
+		( [ Proxy, ProxySections = MoveTemp( ProxySections ) ]( FRHICommandListImmediate& RHICmdList ) mutable
+		  { Proxy->SetSections_RenderThread( RHICmdList, MoveTemp( ProxySections ) ); } );
 
-			KeyToLocation.FindOrAdd( Key1, Corner1 );
-			KeyToLocation.FindOrAdd( Key2, Corner2 );
-		}
+		UpdateBounds();
+		MarkRenderTransformDirty();
 	}
+	else
+		MarkRenderStateDirty();
+
+	if( CollisionType == EHexagonCollisionType::Mesh )
+		UpdateCollision( SectionMask );
+}
+
+void UProceduralHexagonMeshComponent::ClearMesh()
+{
+	SetCollisionType( EHexagonCollisionType::None );
+
+	if( !IsMeshEmpty() )
+		ApplySections( TArray< FHexagonMeshData >(), MAX_uint32 );
+}
+
+bool UProceduralHexagonMeshComponent::IsMeshEmpty() const
+{
+	return !Sections.ContainsByPredicate( []( const FHexagonMeshData& Section ) { return !Section.IsEmpty(); } );
+}
+
+FPrimitiveSceneProxy* UProceduralHexagonMeshComponent::CreateSceneProxy()
+{
+	// Nothing is drawn without a renderer, so dedicated servers and -nullrhi runs never build render data
+	if( IsMeshEmpty() || !FApp::CanEverRender() )
+		return nullptr;
+
+	TArray< TUniquePtr< FHexagonMeshRenderData > > RenderData;
+	for( const FHexagonMeshData& Section: Sections )
+		RenderData.Add( Section.IsEmpty() ? nullptr : MakeUnique< FHexagonMeshRenderData >( Section, GetScene()->GetFeatureLevel() ) );
 
-	if( EdgeConnections.IsEmpty() )
+	return new FHexagonMeshSceneProxy( this, MoveTemp( RenderData ) );
+}
+
+FBoxSphereBounds UProceduralHexagonMeshComponent::CalcBounds( const FTransform& LocalToWorld ) const
+{
+	return LocalBounds.TransformBy( LocalToWorld );
+}
+
+void UProceduralHexagonMeshComponent::SetCollisionType( const EHexagonCollisionType Type )
+{
+	if( Type == CollisionType )
 		return;
 
-	TArray< TArray< FVector > > Polygons;
-	while( !EdgeConnections.IsEmpty() )
+	CollisionType = Type;
+	CollisionBoxes.Reset();
+	UpdateCollision();
+}
+
+void UProceduralHexagonMeshComponent::SetCollisionBoxes( TArray< FKBoxElem >&& Boxes )
+{
+	CollisionType  = EHexagonCollisionType::Boxes;
+	CollisionBoxes = MoveTemp( Boxes );
+	UpdateCollision();
+}
+
+bool UProceduralHexagonMeshComponent::GetPhysicsTriMeshData( FTriMeshCollisionData* CollisionData, bool InUseAllTriData )
+{
+	if( !ContainsPhysicsTriMeshData( InUseAllTriData ) )
+		return false;
+
+	for( int32 SectionIndex = 0; SectionIndex < Sections.Num(); ++SectionIndex )
+	{
+		if( CookingSection != INDEX_NONE && SectionIndex != CookingSection )
+			continue;
+
+		const FHexagonMeshData& Section     = Sections[ SectionIndex ];
+		const int32             FirstVertex = CollisionData->Vertices.Num();
+		CollisionData->Vertices.Append( Section.Vertices );
+
+		for( int32 i = 0; i < Section.Triangles.Num(); i += 3 )
+		{
+			FTriIndices& Triangle = CollisionData->Indices.AddDefaulted_GetRef();
+			Triangle.v0           = FirstVertex + Section.Triangles[ i ];
+			Triangle.v1           = FirstVertex + Section.Triangles[ i + 1 ];
+			Triangle.v2           = FirstVertex + Section.Triangles[ i + 2 ];
+		}
+	}
+
+	CollisionData->bFlipNormals    = true;
+	CollisionData->bDeformableMesh = false;
+	CollisionData->bFastCook       = true;
+	return true;
+}
+
+bool UProceduralHexagonMeshComponent::ContainsPhysicsTriMeshData( bool InUseAllTriData ) const
+{
+	if( CollisionType != EHexagonCollisionType::Mesh )
+		return false;
+
+	if( CookingSection != INDEX_NONE )
+		return Sections.IsValidIndex( CookingSection ) && !Sections[ CookingSection ].IsEmpty();
+
+	return !IsMeshEmpty();
+}
+
+void UProceduralHexagonMeshComponent::UpdateCollision( const uint32 SectionMask )
+{
+	if( CollisionType == EHexagonCollisionType::Mesh )
 	{
-		TArray< FVector >       Loop;
-		const FHexagonVertexKey Start   = EdgeConnections.begin().Key();
-		FHexagonVertexKey       Current = Start;
+		SectionBodySetups.SetNum( Sections.Num() );
+		AsyncSectionBodySetups.SetNum( Sections.Num() );
 
-		while( EdgeConnections.Contains( Current ) )
+		bool Removed = false;
+		for( int32 i = 0; i < Sections.Num(); ++i )
 		{
-			Loop.Add( KeyToLocation.FindChecked( Current ) );
-			Current = EdgeConnections.FindAndRemoveChecked( Current );
+			if( !( SectionMask & 1u << i ) )
+				continue;
+
+			if( Sections[ i ].IsEmpty() )
+			{
+				Removed                     |= SectionBodySetups[ i ] != nullptr;
+				SectionBodySetups[ i ]      = nullptr;
+				AsyncSectionBodySetups[ i ] = nullptr;
+				continue;
+			}
+
+			UBodySetup* NewBodySetup    = CreateBodySetup( CTF_UseComplexAsSimple );
+			AsyncSectionBodySetups[ i ] = NewBodySetup;
+
+			// The section's triangles are copied before this returns, only cooking them runs on a worker thread
+			CookingSection = i;
+			NewBodySetup->CreatePhysicsMeshesAsync( FOnAsyncPhysicsCookFinished::CreateUObject( this, &UProceduralHexagonMeshComponent::FinishCollisionCook, NewBodySetup, i ) );
+			CookingSection = INDEX_NONE;
 		}
 
-		Polygons.Add( Loop );
+		if( Removed )
+			CombineSectionCollision();
+
+		return;
+	}
+
+	// Anything still cooking is outdated now
+	SectionBodySetups.Reset();
+	AsyncSectionBodySetups.Reset();
+
+	if( CollisionType == EHexagonCollisionType::Boxes && !CollisionBoxes.IsEmpty() )
+	{
+		BodySetup                   = CreateBodySetup( CTF_UseSimpleAsComplex );
+		BodySetup->AggGeom.BoxElems = CollisionBoxes;
+		BodySetup->CreatePhysicsMeshes();
 	}
+	else
+		BodySetup = nullptr;
+
+	RecreatePhysicsState();
+}
+
+void UProceduralHexagonMeshComponent::FinishCollisionCook( const bool Success, UBodySetup* CookedBodySetup, const int32 SectionIndex )
+{
+	if( !AsyncSectionBodySetups.IsValidIndex( SectionIndex ) || AsyncSectionBodySetups[ SectionIndex ] != CookedBodySetup )
+		return;
 
-	if( Polygons.IsEmpty() )
+	AsyncSectionBodySetups[ SectionIndex ] = nullptr;
+	if( !Success )
 		return;
 
-	int32 OuterLoopIndex = -1;
-	float MaxArea        = 0;
-	for( int32 i = 0; i < Polygons.Num(); ++i )
+	SectionBodySetups[ SectionIndex ] = CookedBodySetup;
+	CombineSectionCollision();
+}
+
+void UProceduralHexagonMeshComponent::CombineSectionCollision()
+{
+	UBodySetup* NewBodySetup = CreateBodySetup( CTF_UseComplexAsSimple );
+	for( const UBodySetup* SectionBodySetup: SectionBodySetups )
 	{
-		const float Area = FMath::Abs( Signed2DPolygonArea( Polygons[ i ] ) );
-		if( Area < MaxArea )
+		if( SectionBodySetup )
+			NewBodySetup->TriMeshGeometries.Append( SectionBodySetup->TriMeshGeometries );
+	}
+
+	// Marked as created so the body instance takes the shared meshes as they are instead of cooking the whole mesh again
+	NewBodySetup->bCreatedPhysicsMeshes = true;
+
+	BodySetup = NewBodySetup->TriMeshGeometries.IsEmpty() ? nullptr : NewBodySetup;
+	RecreatePhysicsState();
+}
+
+UBodySetup* UProceduralHexagonMeshComponent::CreateBodySetup( const ECollisionTraceFlag CollisionTraceFlag )
+{
+	UBodySetup* NewBodySetup           = NewObject< UBodySetup >( this, NAME_None, RF_Transient );
+	NewBodySetup->BodySetupGuid        = FGuid::NewGuid();
+	NewBodySetup->CollisionTraceFlag   = CollisionTraceFlag;
+	NewBodySetup->bDoubleSidedGeometry = true;
+	return NewBodySetup;
+}
+
+template< typename PolicyType >
+void UProceduralHexagonMeshComponent::GenerateLayers( FHexagonMeshScratch&           Scratch,
+                                                      TArray< TArray< FIntPoint > >& Layers,
+                                                      const int32                    OriginZ,
+                                                      const bool                     IsTop,
+                                                      FHexagonMeshData&              OutMeshData )
+{
+	for( int32 Height = 0; Height < Layers.Num(); ++Height )
+	{
+		if( Layers[ Height ].IsEmpty() )
 			continue;
 
-		MaxArea        = Area;
-		OuterLoopIndex = i;
+		Scratch.Layer.Init( Layers[ Height ] );
+		GenerateLayer< PolicyType >( Scratch, OriginZ + Height, IsTop, OutMeshData );
 	}
+}
 
-	TArray< FVector > MainPolygon = Polygons[ OuterLoopIndex ];
-	Polygons.RemoveAt( OuterLoopIndex );
+template< typename PolicyType >
+void UProceduralHexagonMeshComponent::GenerateLayer( FHexagonMeshScratch& Scratch,
+                                                     const int32          PolygonHeight,
+                                                     const bool           IsTop,
+                                                     FHexagonMeshData&    OutMeshData )
+{
+	const FHexagonLayerGrid&       Layer          = Scratch.Layer;
+	TArray< FHexagonOutlineEdge >& Edges          = Scratch.Edges;
+	TArray< int32 >&               OutlineCorners = Scratch.OutlineCorners;
+	TArray< int32 >&               CornerOrder    = Scratch.CornerOrder;
+	TArray< int32 >&               CornerVertices = Scratch.CornerVertices;
 
-	if( Signed2DPolygonArea( MainPolygon ) < 0 )
-		Algo::Reverse( MainPolygon );
+	const auto ToLatticeY = [ &Layer ]( const int32 CornerId ) { return Layer.ToCornerLattice( CornerId ).Y; };
 
-	for( TArray< FVector >& InnerPolygon: Polygons )
+	const auto ResetCorners = [ &Layer ]( TArray< int32 >& Corners )
 	{
-		if( Signed2DPolygonArea( InnerPolygon ) < 0 )
-			Algo::Reverse( InnerPolygon );
+		Corners.Reset();
+		Corners.SetNumUninitialized( Layer.GetNumCorners() );
+		FMemory::Memset( Corners.GetData(), 0xFF, Corners.Num() * sizeof( int32 ) );
+	};
+
+	ResetCorners( CornerOrder );
+	ResetCorners( CornerVertices );
+	Edges.Reset();
+	OutlineCorners.Reset();
+
+	// Every outline edge spans exactly one slab between two neighbouring vertical lines through the hexagon corners
+	for( int32 Index = Layer.Cells.Find( true ); Index != INDEX_NONE; Index = Layer.Cells.FindFrom( true, Index + 1 ) )
+	{
+		const FIntPoint VoxelCoordinate = Layer.ToCoordinate( Index );
+		for( int32 i = 0; i < 6; ++i )
+		{
+			if( Layer.Contains( VoxelCoordinate + CoordinateDirections[ i ] ) )
+				continue;
 
-		int32 MainBridgeIndex  = -1;
-		int32 InnerBridgeIndex = -1;
-		float MinDistance      = TNumericLimits< float >::Max();
+			const int32 From = Layer.ToCornerId( VoxelCoordinate, ( i + 5 ) % 6 );
+			const int32 To   = Layer.ToCornerId( VoxelCoordinate, i );
 
-		for( int32 i = 0; i < MainPolygon.Num(); ++i )
-		{
-			for( int32 j = 0; j < InnerPolygon.Num(); ++j )
+			for( const int32 CornerId: { From, To } )
 			{
-				const float Distance = FVector::DistSquared( MainPolygon[ i ], InnerPolygon[ j ] );
-				if( Distance > MinDistance )
+				if( CornerOrder[ CornerId ] != INDEX_NONE )
 					continue;
 
-				MinDistance      = Distance;
-				MainBridgeIndex  = i;
-				InnerBridgeIndex = j;
+				CornerOrder[ CornerId ] = 0;
+				OutlineCorners.Add( CornerId );
 			}
+
+			const bool  FromIsLeft = Layer.ToCornerLattice( From ).X < Layer.ToCornerLattice( To ).X;
+			const int32 Left       = FromIsLeft ? From : To;
+			const int32 Right      = FromIsLeft ? To : From;
+
+			Edges.Add( FHexagonOutlineEdge{
+				.Left   = Left,
+				.Right  = Right,
+				.Slab   = Layer.ToCornerLattice( Left ).X,
+				.Height = ToLatticeY( Left ) + ToLatticeY( Right ),
+			} );
 		}
+	}
 
-		TArray< FVector > NewOuterPolygon;
-		for( int32 i = 0; i <= MainBridgeIndex; ++i )
-			NewOuterPolygon.Add( MainPolygon[ i ] );
+	if( Edges.IsEmpty() )
+		return;
 
-		for( int32 i = 0; i <= InnerPolygon.Num(); ++i )
-			NewOuterPolygon.Add( InnerPolygon[ ( InnerBridgeIndex + i ) % InnerPolygon.Num() ] );
+	// Corners on the same vertical line end up next to each other, ordered bottom to top
+	Algo::Sort( OutlineCorners,
+	            [ &Layer ]( const int32 A, const int32 B )
+	            {
+					const FIntPoint LatticeA = Layer.ToCornerLattice( A );
+					const FIntPoint LatticeB = Layer.ToCornerLattice( B );
+					return LatticeA.X < LatticeB.X || ( LatticeA.X == LatticeB.X && LatticeA.Y < LatticeB.Y );
+				} );
 
-		for( int32 i = MainBridgeIndex; i < MainPolygon.Num(); ++i )
-			NewOuterPolygon.Add( MainPolygon[ i ] );
+	for( int32 i = 0; i < OutlineCorners.Num(); ++i )
+		CornerOrder[ OutlineCorners[ i ] ] = i;
 
-		MainPolygon = NewOuterPolygon;
-	}
+	Algo::Sort( Edges, []( const FHexagonOutlineEdge& A, const FHexagonOutlineEdge& B ) { return A.Slab < B.Slab || ( A.Slab == B.Slab && A.Height < B.Height ); } );
 
-	TArray< UE::Geometry::FIndex3i > Triangles;
-	PolygonTriangulation::TriangulateSimplePolygon( MainPolygon, Triangles );
+	const int32         CornerZ = PolygonHeight + IsTop;
+	const FPackedNormal Normal( FVector3f( 0, 0, IsTop ? 1 : -1 ) );
 
-	const int32   Index = OutVertices.Num();
-	const FVector Normal( 0, 0, IsTop ? 1 : -1 );
-	for( const FVector& Vertex: MainPolygon )
+	const auto GetVertex = [ & ]( const int32 CornerId )
 	{
-		OutVertices.Add( Vertex );
-		OutNormals.Add( Normal );
-		OutUVs.AddZeroed();
-	}
+		int32& Vertex = CornerVertices[ CornerId ];
+		if( Vertex == INDEX_NONE )
+		{
+			Vertex = OutMeshData.Vertices.Add( FVector3f( Layer.ToCornerLocation( CornerId, CornerZ ) ) );
+			OutMeshData.Normals.Add( Normal );
+			if constexpr( PolicyType::WithUVs )
+				OutMeshData.UVs.AddZeroed();
+		}
 
-	for( const UE::Geometry::FIndex3i& Triangle: Triangles )
+		return Vertex;
+	};
+
+	const auto AddTriangle = [ & ]( const int32 A, const int32 B, const int32 C )
+	{
+		OutMeshData.Triangles.Add( GetVertex( A ) );
+		OutMeshData.Triangles.Add( GetVertex( IsTop ? B : C ) );
+		OutMeshData.Triangles.Add( GetVertex( IsTop ? C : B ) );
+	};
+
+	// Inside and outside alternate along a vertical line, so the sorted edges of a slab pair up into trapezoids.
+	// Each trapezoid takes every outline corner on its vertical sides, so it shares whole edges with its neighbours and no T-junctions form.
+	for( int32 i = 0; i + 1 < Edges.Num(); i += 2 )
 	{
-		OutTriangles.Add( Index + Triangle.A );
-		OutTriangles.Add( Index + ( IsTop ? Triangle.B : Triangle.C ) );
-		OutTriangles.Add( Index + ( IsTop ? Triangle.C : Triangle.B ) );
+		const FHexagonOutlineEdge& Bottom = Edges[ i ];
+		const FHexagonOutlineEdge& Top    = Edges[ i + 1 ];
+		checkSlow( Bottom.Slab == Top.Slab );
+
+		int32       Left      = CornerOrder[ Bottom.Left ];
+		int32       Right     = CornerOrder[ Bottom.Right ];
+		const int32 LeftLast  = CornerOrder[ Top.Left ];
+		const int32 RightLast = CornerOrder[ Top.Right ];
+
+		while( Left < LeftLast || Right < RightLast )
+		{
+			const bool AdvanceLeft = Right == RightLast
+			                      || ( Left < LeftLast && ToLatticeY( OutlineCorners[ Left + 1 ] ) <= ToLatticeY( OutlineCorners[ Right + 1 ] ) );
+
+			if( AdvanceLeft )
+			{
+				AddTriangle( OutlineCorners[ Left ], OutlineCorners[ Right ], OutlineCorners[ Left + 1 ] );
+				++Left;
+			}
+			else
+			{
+				AddTriangle( OutlineCorners[ Left ], OutlineCorners[ Right ], OutlineCorners[ Right + 1 ] );
+				++Right;
+			}
+		}
 	}
 }
 
-void UProceduralHexagonMeshComponent::GeneratePolygon( const FIntVector&    PolygonCoordinate,
-                                                       TArray< int32 >&     Region,
-                                                       TArray< FVector >&   OutVertices,
-                                                       TArray< int32 >&     OutTriangles,
-                                                       TArray< FVector >&   OutNormals,
-                                                       TArray< FVector2D >& OutUVs ) const
+template< typename PolicyType >
+void UProceduralHexagonMeshComponent::GeneratePolygon( const FIntVector& PolygonCoordinate,
+                                                       const int32       Bottom,
+                                                       const int32       Top,
+                                                       FHexagonMeshData& OutMeshData )
 {
-	if( Region.IsEmpty() )
+	if( Bottom >= Top )
 		return;
 
-	Region.Sort();
-	const FVector TopCenter    = FHexagonVoxel( FIntVector( PolygonCoordinate.X, PolygonCoordinate.Y, Region.Last() ) ).WorldLocation + FVector( 0, 0, HexagonHeight );
-	const FVector BottomCenter = FHexagonVoxel( FIntVector( PolygonCoordinate.X, PolygonCoordinate.Y, Region[ 0 ] ) ).WorldLocation;
-
-	const int32 Side   = PolygonCoordinate.Z;
-	const float Angle1 = FMath::DegreesToRadians( 60 * Side - 60 );
-	const float Angle2 = FMath::DegreesToRadians( 60 * ( Side + 1 ) - 60 );
+	const FVector TopCenter    = FHexagonVoxel( FIntVector( PolygonCoordinate.X, PolygonCoordinate.Y, Top ) ).WorldLocation;
+	const FVector BottomCenter = FHexagonVoxel( FIntVector( PolygonCoordinate.X, PolygonCoordinate.Y, Bottom ) ).WorldLocation;
 
-	const FVector BottomLeft  = BottomCenter + FVector( FMath::Cos( Angle1 ), FMath::Sin( Angle1 ), 0 ) * HexagonRadius;
-	const FVector BottomRight = BottomCenter + FVector( FMath::Cos( Angle2 ), FMath::Sin( Angle2 ), 0 ) * HexagonRadius;
-	const FVector TopLeft     = TopCenter + FVector( FMath::Cos( Angle1 ), FMath::Sin( Angle1 ), 0 ) * HexagonRadius;
-	const FVector TopRight    = TopCenter + FVector( FMath::Cos( Angle2 ), FMath::Sin( Angle2 ), 0 ) * HexagonRadius;
+	const int32   Side        = PolygonCoordinate.Z;
+	const float*  Corner1     = CornerOffsets[ ( Side + 5 ) % 6 ];
+	const float*  Corner2     = CornerOffsets[ Side ];
+	const FVector LeftOffset  = FVector( Corner1[ 0 ], Corner1[ 1 ], 0 ) * HexagonRadius;
+	const FVector RightOffset = FVector( Corner2[ 0 ], Corner2[ 1 ], 0 ) * HexagonRadius;
 
-	const int32 Index = OutVertices.Num();
-	OutVertices.Add( TopLeft );
-	OutVertices.Add( TopRight );
-	OutVertices.Add( BottomLeft );
-	OutVertices.Add( BottomRight );
+	const FVector BottomLeft  = BottomCenter + LeftOffset;
+	const FVector BottomRight = BottomCenter + RightOffset;
+	const FVector TopLeft     = TopCenter + LeftOffset;
+	const FVector TopRight    = TopCenter + RightOffset;
 
-	OutTriangles.Add( Index );
-	OutTriangles.Add( Index + 1 );
-	OutTriangles.Add( Index + 2 );
+	const int32 Index = OutMeshData.Vertices.Num();
+	OutMeshData.Vertices.Add( FVector3f( TopLeft ) );
+	OutMeshData.Vertices.Add( FVector3f( TopRight ) );
+	OutMeshData.Vertices.Add( FVector3f( BottomLeft ) );
+	OutMeshData.Vertices.Add( FVector3f( BottomRight ) );
 
-	OutTriangles.Add( Index + 1 );
-	OutTriangles.Add( Index + 3 );
-	OutTriangles.Add( Index + 2 );
+	OutMeshData.Triangles.Add( Index );
+	OutMeshData.Triangles.Add( Index + 1 );
+	OutMeshData.Triangles.Add( Index + 2 );
 
-	const float   QuadAngle        = FMath::DegreesToRadians( 60 * Side - 30 );
-	const FVector QuadBottomCenter = BottomCenter + FVector( FMath::Cos( QuadAngle ), FMath::Sin( QuadAngle ), 0 ) * HexagonRadius;
-	const FVector Normal           = ( QuadBottomCenter - BottomCenter ).GetSafeNormal2D();
+	OutMeshData.Triangles.Add( Index + 1 );
+	OutMeshData.Triangles.Add( Index + 3 );
+	OutMeshData.Triangles.Add( Index + 2 );
 
+	const FPackedNormal PackedNormal( FVector3f( SideNormals[ Side ][ 0 ], SideNormals[ Side ][ 1 ], 0 ) );
 	for( int32 i = 0; i < 4; ++i )
-		OutNormals.Add( Normal );
+		OutMeshData.Normals.Add( PackedNormal );
 
-	OutUVs.Add( FVector2D( 0, 1 ) );
-	OutUVs.Add( FVector2D( 1, 1 ) );
-	OutUVs.Add( FVector2D( 0, 0 ) );
-	OutUVs.Add( FVector2D( 1, 0 ) );
-}
-
-float UProceduralHexagonMeshComponent::Signed2DPolygonArea( const TArray< FVector >& Polygon ) const
-{
-	float Area = 0;
-	for( int32 j = 0; j < Polygon.Num(); ++j )
+	if constexpr( PolicyType::WithUVs )
 	{
-		const FVector& Point1  = Polygon[ j ];
-		const FVector& Point2  = Polygon[ ( j + 1 ) % Polygon.Num() ];
-		Area                  += Point1.X * Point2.Y - Point2.X * Point1.Y;
+		OutMeshData.UVs.Add( FVector2DHalf( 0, 1 ) );
+		OutMeshData.UVs.Add( FVector2DHalf( 1, 1 ) );
+		OutMeshData.UVs.Add( FVector2DHalf( 0, 0 ) );
+		OutMeshData.UVs.Add( FVector2DHalf( 1, 0 ) );
 	}
+}
+
+template void UProceduralHexagonMeshComponent::Generate< FHexagonMeshPolicy >( const FChunkVoxels&, bool );
+template void UProceduralHexagonMeshComponent::Generate< FPreviewMeshPolicy >( const FChunkVoxels&, bool );
+
+template FHexagonMeshData UProceduralHexagonMeshComponent::BuildMesh< FHexagonMeshPolicy >( const FChunkVoxels&, int32, int32 );
+template FHexagonMeshData UProceduralHexagonMeshComponent::BuildMesh< FChunkMeshPolicy >( const FChunkVoxels&, int32, int32 );
+template FHexagonMeshData UProceduralHexagonMeshComponent::BuildMesh< FPreviewMeshPolicy >( const FChunkVoxels&, int32, int32 );
 
-	return Area;
-}
\ No newline at end of file
+template void UProceduralHexagonMeshComponent::BuildMesh< FHexagonMeshPolicy >( const FChunkVoxels&, FHexagonMeshData&, int32, int32 );
+template void UProceduralHexagonMeshComponent::BuildMesh< FChunkMeshPolicy >( const FChunkVoxels&, FHexagonMeshData&, int32, int32 );
+template void UProceduralHexagonMeshComponent::BuildMesh< FPreviewMeshPolicy >( const FChunkVoxels&, FHexagonMeshData&, int32, int32 );
\ No newline at end of file
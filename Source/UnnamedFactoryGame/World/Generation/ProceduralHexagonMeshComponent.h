@@ -2,48 +2,198 @@
 
 #pragma once
 
+#include "ChunkVoxels.h"
+#include "Components/MeshComponent.h"
 #include "CoreMinimal.h"
 #include "HexagonVoxel.h"
-#include "ProceduralMeshComponent.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "PackedNormal.h"
+#include "PhysicsEngine/BodySetupEnums.h"
+#include "PhysicsEngine/BoxElem.h"
 
 #include "ProceduralHexagonMeshComponent.generated.h"
 
-DECLARE_DELEGATE_RetVal_OneParam( bool, FSkipGenerationDelegate, FHexagonVoxel );
+class UBodySetup;
+struct FHexagonMeshScratch;
 
+/**
+ * Compile time settings of UProceduralHexagonMeshComponent::BuildMesh, every policy gets its own specialized inner loop.
+ * Policies derive from this one and override what they change, BuildMesh is instantiated for each of them in its translation unit.
+ */
+struct FHexagonMeshPolicy
+{
+	/** The outermost ring of columns is not meshed, it only hides the faces of the inner columns looking at it */
+	static constexpr bool IsPadded = false;
+
+	static constexpr bool WithUVs = true;
+};
+
+/**
+ * Chunks are meshed from voxels padded with a ring copied from their neighbours.
+ * The terrain material projects world positions itself, so they carry no UVs.
+ */
+struct FChunkMeshPolicy : FHexagonMeshPolicy
+{
+	static constexpr bool IsPadded = true;
+	static constexpr bool WithUVs  = false;
+};
+
+/** Untextured previews such as the mining tool's outline */
+struct FPreviewMeshPolicy : FHexagonMeshPolicy
+{
+	static constexpr bool WithUVs = false;
+};
+
+/**
+ * Component space mesh in the layout the scene proxy uploads, so handing it to the render thread is a copy and not a conversion.
+ * UVs are empty when the mesh was built without them.
+ */
+struct FHexagonMeshData
+{
+	TArray< FVector3f >     Vertices;
+	TArray< uint32 >        Triangles;
+	TArray< FPackedNormal > Normals;
+	TArray< FVector2DHalf > UVs;
+
+	bool IsEmpty() const { return Triangles.IsEmpty(); }
+
+	/** Keeps the buffers so the next build into it allocates nothing once they have grown large enough */
+	void Reset()
+	{
+		Vertices.Reset();
+		Triangles.Reset();
+		Normals.Reset();
+		UVs.Reset();
+	}
+};
+
+UENUM()
+enum class EHexagonCollisionType : uint8
+{
+	None,
+
+	/** The drawn triangles, cooked in the background */
+	Mesh,
+
+	/** Boxes handed to SetCollisionBoxes, nothing to cook */
+	Boxes,
+};
+
+/**
+ * Draws a hexagon mesh through FHexagonMeshSceneProxy and collides with it or with boxes on request.
+ * The mesh is split into sections that are replaced independently, chunks use one per vertical slab so an edit only rebuilds the slabs it touches.
+ */
 UCLASS( ClassGroup = ( Custom ), meta = ( BlueprintSpawnableComponent ) )
-class UNNAMEDFACTORYGAME_API UProceduralHexagonMeshComponent : public UProceduralMeshComponent
+class UNNAMEDFACTORYGAME_API UProceduralHexagonMeshComponent : public UMeshComponent, public IInterface_CollisionDataProvider
 {
 	GENERATED_BODY()
 
 public:
-	void Generate( const TMap< FIntVector, FHexagonVoxel >& HexagonVoxels, bool GenerateCollision = false, FSkipGenerationDelegate SkipGenerationDelegate = nullptr );
+	template< typename PolicyType = FHexagonMeshPolicy >
+	void Generate( const FChunkVoxels& HexagonVoxels, bool GenerateCollision = false );
+
+	/**
+	 * Builds the mesh without touching the component, safe to call from any thread.
+	 * Only faces lying in the local layers [Bottom, Top) are emitted, so adjacent ranges build seamless sections.
+	 */
+	template< typename PolicyType = FHexagonMeshPolicy >
+	static FHexagonMeshData BuildMesh( const FChunkVoxels& HexagonVoxels, int32 Bottom = 0, int32 Top = MAX_int32 );
+
+	/** Appends to OutMeshData instead, a caller reusing it meshes without any heap allocation once the buffers have grown */
+	template< typename PolicyType = FHexagonMeshPolicy >
+	static void BuildMesh( const FChunkVoxels& HexagonVoxels, FHexagonMeshData& OutMeshData, int32 Bottom = 0, int32 Top = MAX_int32 );
+
+	/**
+	 * Builds a heightfield through the column tops of every Step-th column, for chunks far from the view.
+	 * It spans every stored column and is ringed by a skirt so cracks against neighbours of another detail level stay hidden.
+	 * Like FChunkMeshPolicy it carries no texture coordinates. Safe to call from any thread.
+	 */
+	static FHexagonMeshData BuildLodMesh( const FChunkVoxels& HexagonVoxels, int32 Step );
+
+	/**
+	 * Approximates every solid span by the box of the same footprint area, flat topped hexagons and those boxes tile the plane alike.
+	 * Boxes of neighbouring columns along r with identical spans are merged. Safe to call from any thread.
+	 */
+	static TArray< FKBoxElem > BuildColumnBoxes( const FChunkVoxels& HexagonVoxels );
+
+	/** Replaces the whole mesh with a single section, optionally colliding with it */
+	void ApplyMesh( FHexagonMeshData&& MeshData, bool GenerateCollision = false );
+
+	/**
+	 * Replaces every section whose bit is set in SectionMask by the one at the same index of NewSections, missing ones are cleared.
+	 * An existing scene proxy gets only those sections' buffers swapped instead of being recreated.
+	 */
+	void ApplySections( TArray< FHexagonMeshData >&& NewSections, uint32 SectionMask );
+	void ClearMesh();
+
+	bool IsMeshEmpty() const;
+
+	/**
+	 * Mesh collision is cooked per section in the background and only changed sections are recooked, the previous ones stay in place until they are done.
+	 * Boxes collision without boxes set collides with nothing.
+	 */
+	void SetCollisionType( EHexagonCollisionType Type );
+	void SetCollisionBoxes( TArray< FKBoxElem >&& Boxes );
+
+	EHexagonCollisionType GetCollisionType() const { return CollisionType; }
+
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	virtual int32                 GetNumMaterials() const override { return 1; }
+	virtual FBoxSphereBounds      CalcBounds( const FTransform& LocalToWorld ) const override;
+	virtual UBodySetup*           GetBodySetup() override { return BodySetup; }
+
+	virtual bool GetPhysicsTriMeshData( FTriMeshCollisionData* CollisionData, bool InUseAllTriData ) override;
+	virtual bool ContainsPhysicsTriMeshData( bool InUseAllTriData ) const override;
+	virtual bool WantsNegXTriMesh() override { return false; }
 
 private:
-	void GenerateRegions( TMap< int32, TArray< FIntPoint > >& VisibleVoxelCoordinates,
-	                      bool                                IsTop,
-	                      TArray< FVector >&                  OutVertices,
-	                      TArray< int32 >&                    OutTriangles,
-	                      TArray< FVector >&                  OutNormals,
-	                      TArray< FVector2D >&                OutUVs ) const;
-	void GenerateRegions( TMap< FIntVector, TArray< int32 > >& VisibleVoxelCoordinates,
-	                      TArray< FVector >&                   OutVertices,
-	                      TArray< int32 >&                     OutTriangles,
-	                      TArray< FVector >&                   OutNormals,
-	                      TArray< FVector2D >&                 OutUVs ) const;
-
-	void GeneratePolygon( int32                PolygonHeight,
-	                      TArray< FIntPoint >& Region,
-	                      bool                 IsTop,
-	                      TArray< FVector >&   OutVertices,
-	                      TArray< int32 >&     OutTriangles,
-	                      TArray< FVector >&   OutNormals,
-	                      TArray< FVector2D >& OutUVs ) const;
-	void GeneratePolygon( const FIntVector&    PolygonCoordinate,
-	                      TArray< int32 >&     Region,
-	                      TArray< FVector >&   OutVertices,
-	                      TArray< int32 >&     OutTriangles,
-	                      TArray< FVector >&   OutNormals,
-	                      TArray< FVector2D >& OutUVs ) const;
-
-	float Signed2DPolygonArea( const TArray< FVector >& Polygon ) const;
+	/** Recooks the sections whose bit is set when colliding with the mesh, any other collision type is rebuilt whole */
+	void UpdateCollision( uint32 SectionMask = MAX_uint32 );
+	void FinishCollisionCook( bool Success, UBodySetup* CookedBodySetup, int32 SectionIndex );
+
+	/** Gives the component a body setup holding every cooked section's triangle meshes, nothing is cooked again */
+	void CombineSectionCollision();
+
+	UBodySetup* CreateBodySetup( ECollisionTraceFlag CollisionTraceFlag );
+
+	template< typename PolicyType >
+	static void GenerateLayers( FHexagonMeshScratch&           Scratch,
+	                            TArray< TArray< FIntPoint > >& Layers,
+	                            int32                          OriginZ,
+	                            bool                           IsTop,
+	                            FHexagonMeshData&              OutMeshData );
+
+	/**
+	 * Triangulates Scratch.Layer in one sweep over the vertical lines through the hexagon corners.
+	 * Only outline corners become vertices and every triangle spans a slab between two lines, so holes need no bridging,
+	 * the cost is linear in the layer apart from sorting its outline, and neighbouring triangles always share whole edges.
+	 */
+	template< typename PolicyType >
+	static void GenerateLayer( FHexagonMeshScratch& Scratch, int32 PolygonHeight, bool IsTop, FHexagonMeshData& OutMeshData );
+
+	template< typename PolicyType >
+	static void GeneratePolygon( const FIntVector& PolygonCoordinate, int32 Bottom, int32 Top, FHexagonMeshData& OutMeshData );
+
+	/** Kept on the game thread for collision cooking and for rebuilding the proxy when the render state is recreated */
+	TArray< FHexagonMeshData > Sections;
+	TArray< FBox3f >           SectionBounds;
+
+	FBoxSphereBounds LocalBounds = FBoxSphereBounds( ForceInitToZero );
+
+	EHexagonCollisionType CollisionType = EHexagonCollisionType::None;
+	TArray< FKBoxElem >   CollisionBoxes;
+
+	UPROPERTY( Transient )
+	TObjectPtr< UBodySetup > BodySetup;
+
+	/** Cooked triangle meshes of every section, null for empty ones */
+	UPROPERTY( Transient )
+	TArray< TObjectPtr< UBodySetup > > SectionBodySetups;
+
+	/** The latest cook of every section still running, a finished older one is dropped */
+	UPROPERTY( Transient )
+	TArray< TObjectPtr< UBodySetup > > AsyncSectionBodySetups;
+
+	/** Section GetPhysicsTriMeshData hands out while its body setup gathers the triangles to cook, INDEX_NONE for all of them */
+	int32 CookingSection = INDEX_NONE;
 };
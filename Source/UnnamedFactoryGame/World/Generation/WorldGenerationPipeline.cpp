@@ -0,0 +1,170 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorldGenerationPipeline.h"
+
+#include "WorldGenerationStages.h"
+
+FChunkGenerationBuffer::FChunkGenerationBuffer( const FIntPoint& InCoordinate, const FIntPoint& InOrigin, const FIntPoint& InSize, const int32 InHeight )
+	: Coordinate( InCoordinate )
+	, Origin( InOrigin )
+	, Size( InSize )
+	, Height( InHeight )
+{
+	const int32 NumColumns = GetNumColumns();
+
+	SurfaceHeights.SetNumZeroed( NumColumns );
+	Biomes.SetNumZeroed( NumColumns );
+	SurfaceTypes.Init( EVoxelType::Ground, NumColumns );
+	SurfaceDepths.Init( 1, NumColumns );
+	Types.Init( EVoxelType::Air, NumColumns * Height );
+}
+
+FChunkVoxels FChunkGenerationBuffer::ToVoxels() const
+{
+	int32 ColumnIndex = 0;
+
+	FChunkVoxels Voxels;
+	Voxels.InitColumns( FIntVector( Origin.X, Origin.Y, 0 ),
+	                    FIntVector( Size.X, Size.Y, Height ),
+	                    [ this, &ColumnIndex ]( const FIntPoint& ColumnCoordinate, const TArrayView< EVoxelType > OutTypes )
+	                    {
+							checkSlow( ColumnCoordinate == ToColumn( ColumnIndex ) );
+							FMemory::Memcpy( OutTypes.GetData(), Types.GetData() + ColumnIndex++ * Height, Height * sizeof( EVoxelType ) );
+						} );
+
+	return Voxels;
+}
+
+void UWorldGenerationStage::Prepare( const int32 PipelineSeed )
+{
+	Seed = static_cast< int32 >( HashCombineFast( static_cast< uint32 >( PipelineSeed ), FCrc::StrCrc32( *GetClass()->GetName() ) ) ) + SeedOffset;
+
+	// Settings are hashed through their text form so every property type, including arrays of structs, is covered
+	SettingsHash = FCrc::StrCrc32( *GetClass()->GetName() );
+	for( TFieldIterator< FProperty > It( GetClass() ); It; ++It )
+	{
+		if( It->HasAnyPropertyFlags( CPF_Transient ) )
+			continue;
+
+		FString Value;
+		It->ExportText_InContainer( 0, Value, this, nullptr, this, PPF_None );
+		SettingsHash = HashCombineFast( SettingsHash, FCrc::StrCrc32( *Value ) );
+	}
+}
+
+#if WITH_EDITOR
+void UWorldGenerationStage::PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent )
+{
+	Super::PostEditChangeProperty( PropertyChangedEvent );
+
+	if( UWorldGenerationPipeline* Pipeline = GetTypedOuter< UWorldGenerationPipeline >() )
+		Pipeline->Prepare();
+}
+#endif
+
+UWorldGenerationPipeline* UWorldGenerationPipeline::CreateDefault( UObject* Outer )
+{
+	UWorldGenerationPipeline* Pipeline = NewObject< UWorldGenerationPipeline >( Outer, NAME_None, RF_Transient );
+	Pipeline->Stages.Add( NewObject< UHeightmapGenerationStage >( Pipeline ) );
+	Pipeline->Stages.Add( NewObject< UBiomeGenerationStage >( Pipeline ) );
+	Pipeline->Stages.Add( NewObject< UStrataGenerationStage >( Pipeline ) );
+	Pipeline->Stages.Add( NewObject< UOreGenerationStage >( Pipeline ) );
+	Pipeline->Stages.Add( NewObject< UCaveGenerationStage >( Pipeline ) );
+	Pipeline->Stages.Add( NewObject< UStructureGenerationStage >( Pipeline ) );
+	return Pipeline;
+}
+
+void UWorldGenerationPipeline::Prepare()
+{
+	StageKeys.Reset( Stages.Num() );
+
+	uint32 Key = GetTypeHash( Seed );
+	for( UWorldGenerationStage* Stage: Stages )
+	{
+		if( IsValid( Stage ) && Stage->IsEnabled() )
+		{
+			Stage->Prepare( Seed );
+			Key = HashCombineFast( Key, Stage->GetSettingsHash() );
+		}
+
+		StageKeys.Add( Key );
+	}
+}
+
+FChunkVoxels UWorldGenerationPipeline::Generate( const FIntPoint& ChunkCoordinate, const int32 ChunkSize, const int32 ChunkHeight ) const
+{
+	check( StageKeys.Num() == Stages.Num() );
+
+	const FIntPoint Origin  = ChunkCoordinate * ChunkSize;
+	const FIntPoint Size    = FIntPoint( ChunkSize );
+	const uint32    BaseKey = HashCombineFast( GetTypeHash( ChunkSize ), GetTypeHash( ChunkHeight ) );
+
+	int32                                      NextStage = 0;
+	TSharedPtr< const FChunkGenerationBuffer > Cached    = FindCachedOutput( ChunkCoordinate, BaseKey, NextStage );
+	FChunkGenerationBuffer                     Buffer    = Cached ? *Cached : FChunkGenerationBuffer( ChunkCoordinate, Origin, Size, ChunkHeight );
+
+	for( int32 i = NextStage; i < Stages.Num(); ++i )
+	{
+		const UWorldGenerationStage* Stage = Stages[ i ];
+		if( !IsValid( Stage ) || !Stage->IsEnabled() )
+			continue;
+
+		Stage->Execute( Buffer );
+
+		if( Stage->ShouldCacheOutput() )
+			AddCachedOutput( ChunkCoordinate, HashCombineFast( BaseKey, StageKeys[ i ] ), Buffer );
+	}
+
+	return Buffer.ToVoxels();
+}
+
+#if WITH_EDITOR
+void UWorldGenerationPipeline::PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent )
+{
+	Super::PostEditChangeProperty( PropertyChangedEvent );
+
+	Prepare();
+}
+#endif
+
+TSharedPtr< const FChunkGenerationBuffer > UWorldGenerationPipeline::FindCachedOutput( const FIntPoint& ChunkCoordinate, const uint32 BaseKey, int32& OutNextStage ) const
+{
+	FScopeLock Lock( &CacheCriticalSection );
+
+	for( int32 i = Stages.Num() - 1; i >= 0; --i )
+	{
+		const UWorldGenerationStage* Stage = Stages[ i ];
+		if( !IsValid( Stage ) || !Stage->IsEnabled() || !Stage->ShouldCacheOutput() )
+			continue;
+
+		if( const TSharedPtr< const FChunkGenerationBuffer >* Cached = Cache.Find( FCacheKey( ChunkCoordinate, HashCombineFast( BaseKey, StageKeys[ i ] ) ) ) )
+		{
+			OutNextStage = i + 1;
+			return *Cached;
+		}
+	}
+
+	OutNextStage = 0;
+	return nullptr;
+}
+
+void UWorldGenerationPipeline::AddCachedOutput( const FIntPoint& ChunkCoordinate, const uint32 Key, const FChunkGenerationBuffer& Buffer ) const
+{
+	if( MaxCachedOutputs <= 0 )
+		return;
+
+	FScopeLock Lock( &CacheCriticalSection );
+
+	const FCacheKey CacheKey( ChunkCoordinate, Key );
+	if( Cache.Contains( CacheKey ) )
+		return;
+
+	while( CacheOrder.Num() >= MaxCachedOutputs )
+	{
+		Cache.Remove( CacheOrder[ 0 ] );
+		CacheOrder.RemoveAt( 0, EAllowShrinking::No );
+	}
+
+	Cache.Add( CacheKey, MakeShared< FChunkGenerationBuffer >( Buffer ) );
+	CacheOrder.Add( CacheKey );
+}
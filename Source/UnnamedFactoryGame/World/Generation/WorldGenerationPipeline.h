@@ -0,0 +1,137 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ChunkVoxels.h"
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "HexagonVoxel.h"
+
+#include "WorldGenerationPipeline.generated.h"
+
+/**
+ * Working data of one chunk while it passes through the generation stages.
+ * Covers exactly the columns of the chunk, laid out like FChunkVoxels, the mesher reads the border from the neighbours.
+ */
+struct UNNAMEDFACTORYGAME_API FChunkGenerationBuffer
+{
+	FChunkGenerationBuffer( const FIntPoint& InCoordinate, const FIntPoint& InOrigin, const FIntPoint& InSize, int32 InHeight );
+
+	int32 GetNumColumns() const { return Size.X * Size.Y; }
+
+	int32     ToColumnIndex( const FIntPoint& Column ) const { return ( Column.X - Origin.X ) * Size.Y + Column.Y - Origin.Y; }
+	FIntPoint ToColumn( const int32 ColumnIndex ) const { return FIntPoint( Origin.X + ColumnIndex / Size.Y, Origin.Y + ColumnIndex % Size.Y ); }
+
+	bool IsColumnInside( const FIntPoint& Column ) const
+	{
+		const FIntPoint Local = Column - Origin;
+		return Local.X >= 0 && Local.Y >= 0 && Local.X < Size.X && Local.Y < Size.Y;
+	}
+
+	TArrayView< EVoxelType > GetColumnTypes( const int32 ColumnIndex ) { return MakeArrayView( Types.GetData() + ColumnIndex * Height, Height ); }
+
+	FChunkVoxels ToVoxels() const;
+
+	FIntPoint Coordinate;
+	FIntPoint Origin;
+	FIntPoint Size;
+	int32     Height;
+
+	/** Number of voxels from the bottom up to and including the surface */
+	TArray< int32 > SurfaceHeights;
+
+	TArray< uint8 >      Biomes;
+	TArray< EVoxelType > SurfaceTypes;
+	TArray< uint8 >      SurfaceDepths;
+
+	TArray< EVoxelType > Types;
+};
+
+/**
+ * One step of the world generation pipeline.
+ * Execute runs on worker threads for many chunks at once, so it may only read the stage and write the buffer.
+ * The result must depend on nothing but the seed, the stage settings and the incoming buffer.
+ */
+UCLASS( Abstract, EditInlineNew, DefaultToInstanced, CollapseCategories )
+class UNNAMEDFACTORYGAME_API UWorldGenerationStage : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Called on the game thread before generation starts and whenever the settings change */
+	virtual void Prepare( int32 PipelineSeed );
+
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const PURE_VIRTUAL( UWorldGenerationStage::Execute, );
+
+	bool IsEnabled() const { return Enabled; }
+	bool ShouldCacheOutput() const { return CacheOutput; }
+
+	uint32 GetSettingsHash() const { return SettingsHash; }
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent ) override;
+#endif
+
+protected:
+	int32 GetSeed() const { return Seed; }
+
+	UPROPERTY( EditAnywhere, Category = "Stage" )
+	bool Enabled = true;
+
+	/** Keeps the output of this stage per chunk so changes to later stages do not rerun it */
+	UPROPERTY( EditAnywhere, Category = "Stage" )
+	bool CacheOutput = false;
+
+	UPROPERTY( EditAnywhere, Category = "Stage" )
+	int32 SeedOffset = 0;
+
+private:
+	int32  Seed         = 0;
+	uint32 SettingsHash = 0;
+};
+
+/**
+ * Ordered list of generation stages, the same seed and chunk coordinate always produce identical voxels.
+ */
+UCLASS( BlueprintType )
+class UNNAMEDFACTORYGAME_API UWorldGenerationPipeline : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static UWorldGenerationPipeline* CreateDefault( UObject* Outer );
+
+	/** Must be called on the game thread before Generate and after the stages changed */
+	void Prepare();
+
+	/** Thread safe, generates the ChunkSize x ChunkSize columns of a chunk */
+	FChunkVoxels Generate( const FIntPoint& ChunkCoordinate, int32 ChunkSize, int32 ChunkHeight ) const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent ) override;
+#endif
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Generation" )
+	int32 Seed = 0;
+
+	UPROPERTY( EditAnywhere, Instanced, Category = "Generation" )
+	TArray< TObjectPtr< UWorldGenerationStage > > Stages;
+
+	/** Number of stage outputs kept for reuse across all chunks */
+	UPROPERTY( EditAnywhere, Category = "Generation", meta = ( ClampMin = 0 ) )
+	int32 MaxCachedOutputs = 256;
+
+private:
+	using FCacheKey = TPair< FIntPoint, uint32 >;
+
+	TSharedPtr< const FChunkGenerationBuffer > FindCachedOutput( const FIntPoint& ChunkCoordinate, uint32 BaseKey, int32& OutNextStage ) const;
+	void                                       AddCachedOutput( const FIntPoint& ChunkCoordinate, uint32 Key, const FChunkGenerationBuffer& Buffer ) const;
+
+	/** Hash of the seed and every stage up to and including the index */
+	TArray< uint32 > StageKeys;
+
+	mutable FCriticalSection                                              CacheCriticalSection;
+	mutable TMap< FCacheKey, TSharedPtr< const FChunkGenerationBuffer > > Cache;
+	mutable TArray< FCacheKey >                                           CacheOrder;
+};
@@ -0,0 +1,270 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorldGenerationStages.h"
+
+namespace
+{
+	TArray< float > GenerateNoiseGrid( const FNoiseGenerator& NoiseGenerator, const FChunkGenerationBuffer& Buffer )
+	{
+		TArray< float > Values;
+		Values.SetNumUninitialized( Buffer.GetNumColumns() );
+		NoiseGenerator.GenerateGrid( Buffer.Origin, Buffer.Size, Values );
+		return Values;
+	}
+
+	FNoiseGenerator MakeNoiseGenerator( FNoiseSettings Settings, const int32 Seed )
+	{
+		Settings.Seed = Seed;
+		return FNoiseGenerator( Settings );
+	}
+
+	int32 HexagonDistance( const FIntPoint& Offset ) { return ( FMath::Abs( Offset.X ) + FMath::Abs( Offset.Y ) + FMath::Abs( Offset.X + Offset.Y ) ) / 2; }
+}
+
+UHeightmapGenerationStage::UHeightmapGenerationStage()
+{
+	Noise.WarpAmplitude = 8;
+}
+
+void UHeightmapGenerationStage::Prepare( const int32 PipelineSeed )
+{
+	Super::Prepare( PipelineSeed );
+
+	NoiseGenerator = MakeNoiseGenerator( Noise, GetSeed() );
+}
+
+void UHeightmapGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	const TArray< float > Values = GenerateNoiseGrid( NoiseGenerator, Buffer );
+	const FVector2D       Range( MinHeight * Buffer.Height, MaxHeight * Buffer.Height );
+
+	for( int32 i = 0; i < Buffer.GetNumColumns(); ++i )
+	{
+		const int32 TileHeight     = FMath::RoundToInt( FMath::GetMappedRangeValueClamped( FVector2D( -1.0f, 1.0f ), Range, Values[ i ] ) );
+		Buffer.SurfaceHeights[ i ] = FMath::Clamp( TileHeight + 1, 1, Buffer.Height );
+	}
+}
+
+UBiomeGenerationStage::UBiomeGenerationStage()
+{
+	Noise.Frequency = .004f;
+	Noise.Octaves   = 2;
+
+	Biomes.Add( FBiomeDefinition{ .SurfaceType = EVoxelType::Ground, .SurfaceDepth = 1, .HeightScale = .6f, .HeightOffset = 0 } );
+	Biomes.Add( FBiomeDefinition{ .SurfaceType = EVoxelType::Ground, .SurfaceDepth = 2, .HeightScale = 1, .HeightOffset = 0 } );
+	Biomes.Add( FBiomeDefinition{ .SurfaceType = EVoxelType::Stone, .SurfaceDepth = 1, .HeightScale = 1.25f, .HeightOffset = 1 } );
+}
+
+void UBiomeGenerationStage::Prepare( const int32 PipelineSeed )
+{
+	Super::Prepare( PipelineSeed );
+
+	NoiseGenerator = MakeNoiseGenerator( Noise, GetSeed() );
+}
+
+void UBiomeGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	if( Biomes.IsEmpty() )
+		return;
+
+	const TArray< float > Values    = GenerateNoiseGrid( NoiseGenerator, Buffer );
+	const int32           LastBiome = Biomes.Num() - 1;
+
+	for( int32 i = 0; i < Buffer.GetNumColumns(); ++i )
+	{
+		const float T     = FMath::Clamp( ( Values[ i ] + 1 ) * .5f * Biomes.Num() - .5f, 0.0f, static_cast< float >( LastBiome ) );
+		const int32 Lower = FMath::FloorToInt( T );
+		const int32 Upper = FMath::Min( Lower + 1, LastBiome );
+		const float Alpha = T - Lower;
+
+		const float HeightScale  = FMath::Lerp( Biomes[ Lower ].HeightScale, Biomes[ Upper ].HeightScale, Alpha );
+		const float HeightOffset = FMath::Lerp( static_cast< float >( Biomes[ Lower ].HeightOffset ), static_cast< float >( Biomes[ Upper ].HeightOffset ), Alpha );
+
+		const int32             Biome      = FMath::RoundToInt( T );
+		const FBiomeDefinition& Definition = Biomes[ Biome ];
+
+		Buffer.SurfaceHeights[ i ] = FMath::Clamp( FMath::RoundToInt( Buffer.SurfaceHeights[ i ] * HeightScale + HeightOffset ), 1, Buffer.Height );
+		Buffer.Biomes[ i ]         = static_cast< uint8 >( Biome );
+		Buffer.SurfaceTypes[ i ]   = Definition.SurfaceType;
+		Buffer.SurfaceDepths[ i ]  = static_cast< uint8 >( FMath::Clamp( Definition.SurfaceDepth, 0, 255 ) );
+	}
+}
+
+UStrataGenerationStage::UStrataGenerationStage()
+{
+	Layers.Add( FStratumLayer{ .Type = EVoxelType::Ground, .Thickness = 2 } );
+}
+
+void UStrataGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	for( int32 i = 0; i < Buffer.GetNumColumns(); ++i )
+	{
+		const TArrayView< EVoxelType > Column  = Buffer.GetColumnTypes( i );
+		const int32                    Surface = Buffer.SurfaceHeights[ i ];
+
+		for( int32 Z = Surface; Z < Buffer.Height; ++Z )
+			Column[ Z ] = EVoxelType::Air;
+
+		int32 Z = Surface - 1;
+		for( int32 Depth = 0; Depth < Buffer.SurfaceDepths[ i ] && Z >= 0; ++Depth )
+			Column[ Z-- ] = Buffer.SurfaceTypes[ i ];
+
+		for( const FStratumLayer& Layer: Layers )
+		{
+			for( int32 Depth = 0; Depth < Layer.Thickness && Z >= 0; ++Depth )
+				Column[ Z-- ] = Layer.Type;
+		}
+
+		while( Z >= 0 )
+			Column[ Z-- ] = BaseType;
+	}
+}
+
+UOreGenerationStage::UOreGenerationStage()
+{
+	Ores.Add( FOreDefinition{ .Type = EVoxelType::Coal, .Frequency = .08f, .Threshold = .55f, .MinHeight = 2, .MaxHeight = 24, .Thickness = 2 } );
+	Ores.Add( FOreDefinition{ .Type = EVoxelType::Iron, .Frequency = .1f, .Threshold = .65f, .MinHeight = 0, .MaxHeight = 16, .Thickness = 1 } );
+	Ores.Add( FOreDefinition{ .Type = EVoxelType::Copper, .Frequency = .1f, .Threshold = .7f, .MinHeight = 0, .MaxHeight = 12, .Thickness = 1 } );
+}
+
+void UOreGenerationStage::Prepare( const int32 PipelineSeed )
+{
+	Super::Prepare( PipelineSeed );
+
+	DepositNoise.Reset( Ores.Num() );
+	HeightNoise.Reset( Ores.Num() );
+
+	for( int32 i = 0; i < Ores.Num(); ++i )
+	{
+		DepositNoise.Add( FNoiseGenerator( FNoiseSettings{ .Seed = GetSeed() + i * 2, .Frequency = Ores[ i ].Frequency, .Octaves = 2 } ) );
+		HeightNoise.Add( FNoiseGenerator( FNoiseSettings{ .Seed = GetSeed() + i * 2 + 1, .Frequency = Ores[ i ].Frequency * .5f, .Octaves = 1 } ) );
+	}
+}
+
+void UOreGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	for( int32 OreIndex = 0; OreIndex < Ores.Num(); ++OreIndex )
+	{
+		const FOreDefinition& Ore = Ores[ OreIndex ];
+		if( Ore.Threshold >= 1 )
+			continue;
+
+		const TArray< float > Deposits = GenerateNoiseGrid( DepositNoise[ OreIndex ], Buffer );
+		const TArray< float > Heights  = GenerateNoiseGrid( HeightNoise[ OreIndex ], Buffer );
+
+		for( int32 i = 0; i < Buffer.GetNumColumns(); ++i )
+		{
+			if( Deposits[ i ] <= Ore.Threshold )
+				continue;
+
+			const float Strength      = ( Deposits[ i ] - Ore.Threshold ) / ( 1 - Ore.Threshold );
+			const int32 HalfThickness = FMath::RoundToInt( Ore.Thickness * Strength );
+			const int32 Center        = FMath::RoundToInt( FMath::Lerp( static_cast< float >( Ore.MinHeight ), static_cast< float >( Ore.MaxHeight ), ( Heights[ i ] + 1 ) * .5f ) );
+
+			const int32 Bottom = FMath::Max( Center - HalfThickness, 0 );
+			const int32 Top    = FMath::Min3( Center + HalfThickness, Buffer.SurfaceHeights[ i ] - 1, Buffer.Height - 1 );
+
+			const TArrayView< EVoxelType > Column = Buffer.GetColumnTypes( i );
+			for( int32 Z = Bottom; Z <= Top; ++Z )
+			{
+				if( Column[ Z ] == Ore.HostType )
+					Column[ Z ] = Ore.Type;
+			}
+		}
+	}
+}
+
+UCaveGenerationStage::UCaveGenerationStage()
+{
+	Noise.Frequency     = .03f;
+	Noise.Octaves       = 2;
+	Noise.WarpFrequency = .02f;
+	Noise.WarpAmplitude = 4;
+}
+
+void UCaveGenerationStage::Prepare( const int32 PipelineSeed )
+{
+	Super::Prepare( PipelineSeed );
+
+	TunnelNoise = MakeNoiseGenerator( Noise, GetSeed() );
+	HeightNoise = FNoiseGenerator( FNoiseSettings{ .Seed = GetSeed() + 1, .Frequency = Noise.Frequency * .5f, .Octaves = 1 } );
+}
+
+void UCaveGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	if( TunnelWidth <= 0 )
+		return;
+
+	const TArray< float > Tunnels = GenerateNoiseGrid( TunnelNoise, Buffer );
+	const TArray< float > Heights = GenerateNoiseGrid( HeightNoise, Buffer );
+
+	for( int32 i = 0; i < Buffer.GetNumColumns(); ++i )
+	{
+		const float Distance = FMath::Abs( Tunnels[ i ] );
+		if( Distance >= TunnelWidth )
+			continue;
+
+		const int32 TunnelRadius = FMath::RoundToInt( Radius * ( 1 - Distance / TunnelWidth ) );
+		const int32 Center       = FMath::RoundToInt( FMath::Lerp( static_cast< float >( MinHeight ), static_cast< float >( MaxHeight ), ( Heights[ i ] + 1 ) * .5f ) );
+
+		// The bottom layer is never carved so the world has no holes
+		const int32 Bottom = FMath::Max( Center - TunnelRadius, 1 );
+		const int32 Top    = FMath::Min3( Center + TunnelRadius, Buffer.SurfaceHeights[ i ] - 1 - MinCover, Buffer.Height - 1 );
+
+		const TArrayView< EVoxelType > Column = Buffer.GetColumnTypes( i );
+		for( int32 Z = Bottom; Z <= Top; ++Z )
+			Column[ Z ] = EVoxelType::Air;
+	}
+}
+
+void UStructureGenerationStage::Execute( FChunkGenerationBuffer& Buffer ) const
+{
+	const int32 MaxStructureHeight = FMath::Max( MinHeight, MaxHeight );
+
+	// Every cell whose structure can reach the buffer, visited in a fixed order so overlaps resolve the same in every chunk
+	const FIntPoint Min = Buffer.Origin - FIntPoint( Radius );
+	const FIntPoint Max = Buffer.Origin + Buffer.Size + FIntPoint( Radius );
+
+	const int32 CellMinX = FMath::FloorToInt( static_cast< float >( Min.X ) / Spacing );
+	const int32 CellMinY = FMath::FloorToInt( static_cast< float >( Min.Y ) / Spacing );
+	const int32 CellMaxX = FMath::FloorToInt( static_cast< float >( Max.X - 1 ) / Spacing );
+	const int32 CellMaxY = FMath::FloorToInt( static_cast< float >( Max.Y - 1 ) / Spacing );
+
+	for( int32 CellX = CellMinX; CellX <= CellMaxX; ++CellX )
+	{
+		for( int32 CellY = CellMinY; CellY <= CellMaxY; ++CellY )
+		{
+			const uint32 Hash = MurmurFinalize32( HashCombineFast( HashCombineFast( static_cast< uint32 >( GetSeed() ), static_cast< uint32 >( CellX ) ), static_cast< uint32 >( CellY ) ) );
+			if( ( Hash & 0xffff ) / 65536.0f >= Chance )
+				continue;
+
+			const uint32    PositionHash = MurmurFinalize32( Hash );
+			const FIntPoint Center( CellX * Spacing + static_cast< int32 >( PositionHash % Spacing ), CellY * Spacing + static_cast< int32 >( ( PositionHash >> 16 ) % Spacing ) );
+			const int32     Height = MinHeight + static_cast< int32 >( MurmurFinalize32( PositionHash ) % ( MaxStructureHeight - MinHeight + 1 ) );
+
+			for( int32 Q = -Radius; Q <= Radius; ++Q )
+			{
+				for( int32 R = FMath::Max( -Radius, -Q - Radius ); R <= FMath::Min( Radius, -Q + Radius ); ++R )
+				{
+					const FIntPoint Column = Center + FIntPoint( Q, R );
+					if( !Buffer.IsColumnInside( Column ) )
+						continue;
+
+					const int32 ColumnHeight = Height * ( Radius + 1 - HexagonDistance( FIntPoint( Q, R ) ) ) / ( Radius + 1 );
+					if( ColumnHeight <= 0 )
+						continue;
+
+					const int32                    ColumnIndex = Buffer.ToColumnIndex( Column );
+					const TArrayView< EVoxelType > Types       = Buffer.GetColumnTypes( ColumnIndex );
+					const int32                    Bottom      = Buffer.SurfaceHeights[ ColumnIndex ];
+					const int32                    Top         = FMath::Min( Bottom + ColumnHeight, Buffer.Height );
+
+					for( int32 Z = Bottom; Z < Top; ++Z )
+						Types[ Z ] = Type;
+
+					Buffer.SurfaceHeights[ ColumnIndex ] = Top;
+				}
+			}
+		}
+	}
+}
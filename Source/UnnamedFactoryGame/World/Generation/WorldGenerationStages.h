@@ -0,0 +1,225 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NoiseGenerator.h"
+#include "WorldGenerationPipeline.h"
+
+#include "WorldGenerationStages.generated.h"
+
+/**
+ * Fills the surface heights from fractal noise
+ */
+UCLASS( DisplayName = "Heightmap" )
+class UNNAMEDFACTORYGAME_API UHeightmapGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	UHeightmapGenerationStage();
+
+	virtual void Prepare( int32 PipelineSeed ) override;
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Heightmap" )
+	FNoiseSettings Noise;
+
+	/** Surface range as a fraction of the chunk height */
+	UPROPERTY( EditAnywhere, Category = "Heightmap", meta = ( ClampMin = 0, ClampMax = 1 ) )
+	float MinHeight = 0;
+	UPROPERTY( EditAnywhere, Category = "Heightmap", meta = ( ClampMin = 0, ClampMax = 1 ) )
+	float MaxHeight = 1;
+
+private:
+	FNoiseGenerator NoiseGenerator;
+};
+
+USTRUCT( BlueprintType )
+struct FBiomeDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, Category = "Biome" )
+	EVoxelType SurfaceType = EVoxelType::Ground;
+	UPROPERTY( EditAnywhere, Category = "Biome", meta = ( ClampMin = 0, ClampMax = 255 ) )
+	int32 SurfaceDepth = 1;
+
+	UPROPERTY( EditAnywhere, Category = "Biome" )
+	float HeightScale = 1;
+	UPROPERTY( EditAnywhere, Category = "Biome" )
+	int32 HeightOffset = 0;
+};
+
+/**
+ * Picks a biome per column from low frequency noise, reshapes the heights and sets the surface material
+ */
+UCLASS( DisplayName = "Biome" )
+class UNNAMEDFACTORYGAME_API UBiomeGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	UBiomeGenerationStage();
+
+	virtual void Prepare( int32 PipelineSeed ) override;
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Biome" )
+	FNoiseSettings Noise;
+
+	/** Ordered along the noise range, heights blend between neighbouring entries */
+	UPROPERTY( EditAnywhere, Category = "Biome" )
+	TArray< FBiomeDefinition > Biomes;
+
+private:
+	FNoiseGenerator NoiseGenerator;
+};
+
+USTRUCT( BlueprintType )
+struct FStratumLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, Category = "Stratum" )
+	EVoxelType Type = EVoxelType::Stone;
+	UPROPERTY( EditAnywhere, Category = "Stratum", meta = ( ClampMin = 0 ) )
+	int32 Thickness = 1;
+};
+
+/**
+ * Fills every column from its surface down with the biome surface, the layers and finally the base type
+ */
+UCLASS( DisplayName = "Strata" )
+class UNNAMEDFACTORYGAME_API UStrataGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	UStrataGenerationStage();
+
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	/** Layers below the biome surface, from top to bottom */
+	UPROPERTY( EditAnywhere, Category = "Strata" )
+	TArray< FStratumLayer > Layers;
+
+	UPROPERTY( EditAnywhere, Category = "Strata" )
+	EVoxelType BaseType = EVoxelType::Stone;
+};
+
+USTRUCT( BlueprintType )
+struct FOreDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, Category = "Ore" )
+	EVoxelType Type = EVoxelType::Coal;
+	UPROPERTY( EditAnywhere, Category = "Ore" )
+	EVoxelType HostType = EVoxelType::Stone;
+
+	UPROPERTY( EditAnywhere, Category = "Ore" )
+	float Frequency = .08f;
+	/** Noise value above which a column contains the deposit */
+	UPROPERTY( EditAnywhere, Category = "Ore", meta = ( ClampMin = -1, ClampMax = 1 ) )
+	float Threshold = .5f;
+
+	UPROPERTY( EditAnywhere, Category = "Ore", meta = ( ClampMin = 0 ) )
+	int32 MinHeight = 0;
+	UPROPERTY( EditAnywhere, Category = "Ore", meta = ( ClampMin = 0 ) )
+	int32 MaxHeight = 16;
+	UPROPERTY( EditAnywhere, Category = "Ore", meta = ( ClampMin = 0 ) )
+	int32 Thickness = 2;
+};
+
+/**
+ * Replaces host voxels with ore deposits shaped as lenses around a noise driven height
+ */
+UCLASS( DisplayName = "Ores" )
+class UNNAMEDFACTORYGAME_API UOreGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	UOreGenerationStage();
+
+	virtual void Prepare( int32 PipelineSeed ) override;
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Ores" )
+	TArray< FOreDefinition > Ores;
+
+private:
+	TArray< FNoiseGenerator > DepositNoise;
+	TArray< FNoiseGenerator > HeightNoise;
+};
+
+/**
+ * Carves tunnels along the zero crossings of a noise field
+ */
+UCLASS( DisplayName = "Caves" )
+class UNNAMEDFACTORYGAME_API UCaveGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	UCaveGenerationStage();
+
+	virtual void Prepare( int32 PipelineSeed ) override;
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Caves" )
+	FNoiseSettings Noise;
+
+	/** Width of the tunnels in noise units around the zero crossing */
+	UPROPERTY( EditAnywhere, Category = "Caves", meta = ( ClampMin = 0 ) )
+	float TunnelWidth = .06f;
+
+	UPROPERTY( EditAnywhere, Category = "Caves", meta = ( ClampMin = 0 ) )
+	int32 Radius = 2;
+	UPROPERTY( EditAnywhere, Category = "Caves", meta = ( ClampMin = 1 ) )
+	int32 MinHeight = 2;
+	UPROPERTY( EditAnywhere, Category = "Caves", meta = ( ClampMin = 1 ) )
+	int32 MaxHeight = 20;
+
+	/** Solid voxels always left between a tunnel and the surface */
+	UPROPERTY( EditAnywhere, Category = "Caves", meta = ( ClampMin = 0 ) )
+	int32 MinCover = 2;
+
+private:
+	FNoiseGenerator TunnelNoise;
+	FNoiseGenerator HeightNoise;
+};
+
+/**
+ * Places rock spires on a jittered grid, evaluated per column so they continue seamlessly across chunks
+ */
+UCLASS( DisplayName = "Structures" )
+class UNNAMEDFACTORYGAME_API UStructureGenerationStage : public UWorldGenerationStage
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Execute( FChunkGenerationBuffer& Buffer ) const override;
+
+protected:
+	UPROPERTY( EditAnywhere, Category = "Structures" )
+	EVoxelType Type = EVoxelType::Stone;
+
+	UPROPERTY( EditAnywhere, Category = "Structures", meta = ( ClampMin = 1 ) )
+	int32 Spacing = 24;
+	UPROPERTY( EditAnywhere, Category = "Structures", meta = ( ClampMin = 0, ClampMax = 1 ) )
+	float Chance = .25f;
+
+	UPROPERTY( EditAnywhere, Category = "Structures", meta = ( ClampMin = 0 ) )
+	int32 Radius = 2;
+	UPROPERTY( EditAnywhere, Category = "Structures", meta = ( ClampMin = 0 ) )
+	int32 MinHeight = 3;
+	UPROPERTY( EditAnywhere, Category = "Structures", meta = ( ClampMin = 0 ) )
+	int32 MaxHeight = 8;
+};
@@ -2,14 +2,65 @@
 
 #include "WorldGenerationSubSystem.h"
 
+#include "ChunkMeshPool.h"
 #include "Kismet/GameplayStatics.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/Paths.h"
 #include "UnnamedFactoryGame/Player/FactoryPlayer.h"
+#include "WorldGenerationPipeline.h"
 
-UWorldGenerationSubSystem::UWorldGenerationSubSystem()
+void UWorldGenerationSubSystem::Initialize( FSubsystemCollectionBase& Collection )
 {
-	static ConstructorHelpers::FClassFinder< AChunk > ClassFinder( TEXT( "/Game/Blueprints/World/Generation/Chunk_BP" ) );
-	if( ClassFinder.Succeeded() )
-		ChunkClass = ClassFinder.Class;
+	Super::Initialize( Collection );
+
+	FChunk::StaticSize   = ChunkSize;
+	FChunk::StaticHeight = ChunkHeight;
+
+	// Section masks are 32 bits wide
+	FChunk::StaticSectionHeight = FMath::Max( MeshSectionHeight, FMath::DivideAndRoundUp( ChunkHeight, 32 ) );
+
+	GenerationPipeline = GenerationPipelineAsset.LoadSynchronous();
+	if( !GenerationPipeline )
+		GenerationPipeline = UWorldGenerationPipeline::CreateDefault( this );
+
+	GenerationPipeline->Prepare();
+
+	ChunkMaterial = ChunkMaterialAsset.LoadSynchronous();
+
+	Scheduler = MakeUnique< FChunkJobScheduler >( MaxConcurrentJobs );
+
+	Storage = MakeUnique< FChunkRegionStorage >( FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "Regions" ), GetWorld()->GetName() ) );
+}
+
+void UWorldGenerationSubSystem::Deinitialize()
+{
+	Scheduler.Reset();
+
+	for( TPair< FIntPoint, FChunk >& Chunk: Chunks )
+	{
+		if( Chunk.Value.HasUnsavedChanges && !Chunk.Value.Voxels.IsEmpty() )
+			Storage->SaveChunk( Chunk.Key, MoveTemp( Chunk.Value.Voxels ) );
+	}
+
+	Chunks.Empty();
+	Storage.Reset();
+
+	Super::Deinitialize();
+}
+
+void UWorldGenerationSubSystem::OnWorldBeginPlay( UWorld& InWorld )
+{
+	Super::OnWorldBeginPlay( InWorld );
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	// Hexagonal range of GenerationDistance - 1 rings around the center chunk
+	const int32 Range        = GenerationDistance - 1;
+	const int32 MeshPoolSize = FMath::CeilToInt32( ( 3 * Range * ( Range + 1 ) + 1 ) * MeshPoolScale );
+
+	MeshPool = InWorld.SpawnActor< AChunkMeshPool >( SpawnParameters );
+	MeshPool->Init( MeshPoolSize, ChunkMaterial );
 }
 
 void UWorldGenerationSubSystem::Tick( const float DeltaTime )
@@ -17,47 +68,58 @@ void UWorldGenerationSubSystem::Tick( const float DeltaTime )
 	Super::Tick( DeltaTime );
 
 	const AFactoryPlayer* Player = AFactoryPlayer::Get( this );
-	if( !IsValid( Player ) )
+	if( !IsValid( Player ) || !IsValid( MeshPool ) )
 		return;
 
-	int32           ChunksGenerated = 0;
-	const FIntPoint Chunk           = AChunk::WorldToChunk( Player->GetActorLocation() );
-	for( int32 Q = -GenerationDistance; Q < GenerationDistance; Q++ )
-	{
-		for( int32 R = -GenerationDistance; R < GenerationDistance; R++ )
-		{
-			FIntPoint Other = Chunk + FIntPoint( Q, R );
-			if( IsWithinDistance( Chunk, Other ) && UpdateChunk( Other, ChunksGenerated > 0 ) )
-				ChunksGenerated++;
-		}
-	}
+	ViewLocation  = Player->GetActorLocation();
+	ViewDirection = Player->GetViewRotation().Vector().GetSafeNormal2D();
+
+	const FIntPoint Center = FChunk::WorldToChunk( ViewLocation );
+	if( !StreamingCenter.IsSet() || StreamingCenter.GetValue() != Center )
+		UpdateStreaming( Center );
+	else if( FVector::DotProduct( ViewDirection, PrioritizedViewDirection ) < ReprioritizeViewDot )
+		ReprioritizeJobs();
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime   = StartTime + StreamingFrameBudget / 1000.;
+
+	StreamingStats.NumActivated = 0;
+	StreamingStats.NumUploaded  = 0;
+
+	ActivatePendingChunks( EndTime );
+	Scheduler->Update( EndTime );
+
+	UpdateOutOfRangeChunks();
+	UpdateCollisionChunks();
+
+	StreamingStats.NumPendingActivations = PendingActivations.Num();
+	StreamingStats.NumPendingJobs        = Scheduler->GetNumPending();
+	StreamingStats.NumRunningJobs        = Scheduler->GetNumRunning();
+	StreamingStats.NumFinishedJobs       = Scheduler->GetNumFinished();
+	StreamingStats.Time                  = FPlatformTime::Seconds() - StartTime;
 }
 
-AChunk* UWorldGenerationSubSystem::GetChunk( const FVector& WorldLocation )
+const FChunk* UWorldGenerationSubSystem::GetChunk( const FVector& WorldLocation ) const
 {
-	const FIntPoint Chunk = AChunk::WorldToChunk( WorldLocation );
+	const FIntPoint Chunk = FChunk::WorldToChunk( WorldLocation );
 	return GetChunk( Chunk );
 }
 
-AChunk* UWorldGenerationSubSystem::GetChunk( const FIntVector& VoxelCoordinate )
+const FChunk* UWorldGenerationSubSystem::GetChunk( const FIntVector& VoxelCoordinate ) const
 {
-	const FIntPoint Chunk = AChunk::VoxelToChunk( VoxelCoordinate );
+	const FIntPoint Chunk = FChunk::VoxelToChunk( VoxelCoordinate );
 	return GetChunk( Chunk );
 }
 
-AChunk* UWorldGenerationSubSystem::GetChunk( const FIntPoint& ChunkCoordinate )
+const FChunk* UWorldGenerationSubSystem::GetChunk( const FIntPoint& ChunkCoordinate ) const
 {
-	TObjectPtr< AChunk >* Chunk = Chunks.Find( ChunkCoordinate );
-	if( !Chunk )
-		return nullptr;
-
-	return *Chunk;
+	return Chunks.Find( ChunkCoordinate );
 }
 
-bool UWorldGenerationSubSystem::GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel )
+bool UWorldGenerationSubSystem::GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel ) const
 {
-	const AChunk* Chunk = GetChunk( WorldLocation );
-	if( !IsValid( Chunk ) )
+	const FChunk* Chunk = GetChunk( WorldLocation );
+	if( !Chunk )
 		return false;
 
 	if( !Chunk->GetVoxel( FHexagonVoxel::WorldToVoxel( WorldLocation ), OutVoxel ) )
@@ -66,10 +128,10 @@ bool UWorldGenerationSubSystem::GetVoxel( const FVector& WorldLocation, FHexagon
 	return true;
 }
 
-bool UWorldGenerationSubSystem::GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel )
+bool UWorldGenerationSubSystem::GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const
 {
-	const AChunk* Chunk = GetChunk( VoxelCoordinate );
-	if( !IsValid( Chunk ) )
+	const FChunk* Chunk = GetChunk( VoxelCoordinate );
+	if( !Chunk )
 		return false;
 
 	if( !Chunk->GetVoxel( VoxelCoordinate, OutVoxel ) )
@@ -78,30 +140,613 @@ bool UWorldGenerationSubSystem::GetVoxel( const FIntVector& VoxelCoordinate, FHe
 	return true;
 }
 
-bool UWorldGenerationSubSystem::UpdateChunk( const FIntPoint& Chunk, const bool OnlyVisibility )
+bool UWorldGenerationSubSystem::SetVoxel( const FIntVector& VoxelCoordinate, const EVoxelType Type )
 {
-	const TObjectPtr< AChunk >* ChunkActorPtr = Chunks.Find( Chunk );
-	if( ChunkActorPtr && IsValid( *ChunkActorPtr ) )
-	{
-		( *ChunkActorPtr )->SetVisible();
+	const FIntPoint ChunkCoordinate = FChunk::VoxelToChunk( VoxelCoordinate );
+
+	FChunk* Chunk = Chunks.Find( ChunkCoordinate );
+	if( !Chunk || !Chunk->Voxels.IsInside( VoxelCoordinate ) || Chunk->Voxels.GetType( VoxelCoordinate ) == Type )
 		return false;
+
+	Chunk->Voxels.SetType( VoxelCoordinate, Type );
+	Chunk->HasUnsavedChanges = true;
+
+	// Cells beside the edited column can hang on to it
+	TArray< FIntPoint, TInlineAllocator< 7 > > WalkColumns = { FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) };
+	for( const FIntPoint& Direction: CoordinateDirections )
+		WalkColumns.Add( WalkColumns[ 0 ] + Direction );
+
+	UpdateWalkGraph( WalkColumns );
+
+	// The faces this edit exposes or hides can belong to the voxels above and below
+	const int32  LocalZ   = VoxelCoordinate.Z - Chunk->Voxels.GetOrigin().Z;
+	const uint32 Sections = FChunk::GetSectionMask( LocalZ - 1, LocalZ + 2 );
+	RequestChunkMesh( *Chunk, Sections );
+
+	// Neighbouring chunks mesh their border against this voxel
+	for( const FIntPoint& Direction: CoordinateDirections )
+	{
+		const FIntPoint NeighbourCoordinate = FChunk::VoxelToChunk( VoxelCoordinate + FIntVector( Direction.X, Direction.Y, 0 ) );
+		if( NeighbourCoordinate == ChunkCoordinate )
+			continue;
+
+		FChunk* Neighbour = Chunks.Find( NeighbourCoordinate );
+		if( Neighbour && !Neighbour->Voxels.IsEmpty() )
+			RequestChunkMesh( *Neighbour, Sections );
 	}
 
-	if( OnlyVisibility )
-		return false;
+	return true;
+}
+
+void UWorldGenerationSubSystem::AddCollisionSource( const AActor* Actor )
+{
+	CollisionSources.AddUnique( Actor );
+}
+
+void UWorldGenerationSubSystem::RemoveCollisionSource( const AActor* Actor )
+{
+	CollisionSources.Remove( Actor );
+}
+
+void UWorldGenerationSubSystem::UpdateStreaming( const FIntPoint& Center )
+{
+	StreamingCenter = Center;
+
+	TSet< FIntPoint > NewChunksInRange;
+	NewChunksInRange.Reserve( ChunksInRange.Num() );
+
+	const int32 Range = GenerationDistance - 1;
+	for( int32 Q = -Range; Q <= Range; ++Q )
+	{
+		for( int32 R = FMath::Max( -Range, -Q - Range ); R <= FMath::Min( Range, -Q + Range ); ++R )
+			NewChunksInRange.Add( Center + FIntPoint( Q, R ) );
+	}
+
+	const double Time = GetWorld()->GetTimeSeconds();
+	for( const FIntPoint& ChunkCoordinate: ChunksInRange )
+	{
+		if( !NewChunksInRange.Contains( ChunkCoordinate ) )
+			LeaveRange( ChunkCoordinate, Time );
+	}
+
+	// The old mesh stays shown until the one at the new detail level is ready
+	for( const FIntPoint& ChunkCoordinate: NewChunksInRange )
+	{
+		FChunk*     Chunk = Chunks.Find( ChunkCoordinate );
+		const int32 Lod   = GetChunkLod( ChunkCoordinate );
+		if( !Chunk || Chunk->Lod == Lod )
+			continue;
+
+		Chunk->Lod = Lod;
+		if( !Chunk->Voxels.IsEmpty() )
+			RequestChunkMesh( *Chunk );
+	}
+
+	for( const FIntPoint& ChunkCoordinate: NewChunksInRange )
+	{
+		if( !ChunksInRange.Contains( ChunkCoordinate ) )
+			EnterRange( ChunkCoordinate );
+	}
+
+	ChunksInRange = MoveTemp( NewChunksInRange );
+
+	ReprioritizeJobs();
+
+	// Neighbours that were awaited may have left the range without ever loading
+	for( const FIntPoint& ChunkCoordinate: ChunksAwaitingNeighbours.Array() )
+	{
+		if( FChunk* Chunk = Chunks.Find( ChunkCoordinate ) )
+			RequestChunkMesh( *Chunk, 0 );
+		else
+			ChunksAwaitingNeighbours.Remove( ChunkCoordinate );
+	}
+}
+
+void UWorldGenerationSubSystem::EnterRange( const FIntPoint& ChunkCoordinate )
+{
+	if( FChunk* Chunk = Chunks.Find( ChunkCoordinate ) )
+	{
+		Chunk->IsInRange = true;
+
+		if( Chunk->Mesh.IsValid() )
+			Chunk->Mesh->SetVisibility( true );
+
+		if( !Chunk->Voxels.IsEmpty() && !Chunk->IsMeshPending && ( !Chunk->Mesh.IsValid() || Chunk->DirtySections != 0 ) )
+			RequestChunkMesh( *Chunk );
+
+		return;
+	}
+
+	PendingActivations.Add( ChunkCoordinate );
+}
+
+void UWorldGenerationSubSystem::LeaveRange( const FIntPoint& ChunkCoordinate, const double Time )
+{
+	FChunk* Chunk = Chunks.Find( ChunkCoordinate );
+	if( !Chunk )
+		return;
+
+	Chunk->IsInRange     = false;
+	Chunk->LeftRangeTime = Time;
+	HideQueue.Add( ChunkCoordinate, Time );
+}
+
+void UWorldGenerationSubSystem::ActivatePendingChunks( const double EndTime )
+{
+	// At least one chunk per frame so streaming never stalls on a tight budget
+	while( !PendingActivations.IsEmpty() && ( StreamingStats.NumActivated == 0 || FPlatformTime::Seconds() < EndTime ) )
+	{
+		const FIntPoint ChunkCoordinate = PendingActivations.Pop( EAllowShrinking::No );
+
+		FChunk& Chunk       = Chunks.Add( ChunkCoordinate, FChunk( ChunkCoordinate ) );
+		Chunk.IsInRange     = true;
+		Chunk.Lod           = GetChunkLod( ChunkCoordinate );
+		Chunk.IsMeshPending = true;
+
+		LoadChunkVoxels( ChunkCoordinate );
+		++StreamingStats.NumActivated;
+	}
+}
+
+void UWorldGenerationSubSystem::UpdateOutOfRangeChunks()
+{
+	const double Time = GetWorld()->GetTimeSeconds();
+
+	// Both queues are ordered by the time the chunk left the range, entries of chunks that came back or left again later are stale
+	const auto PopExpired = [ this, Time ]( TRingBuffer< TPair< FIntPoint, double > >& Queue, const float Delay ) -> FChunk*
+	{
+		while( !Queue.IsEmpty() && Time - Queue.First().Value > Delay )
+		{
+			const TPair< FIntPoint, double > Entry = Queue.PopFrontValue();
+
+			FChunk* Chunk = Chunks.Find( Entry.Key );
+			if( Chunk && !Chunk->IsInRange && Chunk->LeftRangeTime == Entry.Value )
+				return Chunk;
+		}
+
+		return nullptr;
+	};
+
+	while( FChunk* Chunk = PopExpired( HideQueue, HideDelay ) )
+	{
+		if( Chunk->Mesh.IsValid() )
+			Chunk->Mesh->SetVisibility( false );
+
+		UnloadQueue.Add( Chunk->Coordinate, Chunk->LeftRangeTime );
+	}
+
+	// Neighbours keep their walk edges into unloaded chunks, searches skip the cells that are gone
+	while( FChunk* Chunk = PopExpired( UnloadQueue, UnloadDelay ) )
+	{
+		const FIntPoint ChunkCoordinate = Chunk->Coordinate;
+		UnloadChunk( *Chunk );
+		Chunks.Remove( ChunkCoordinate );
+		OnChunkUnloaded.Broadcast( ChunkCoordinate );
+	}
+}
+
+void UWorldGenerationSubSystem::ReprioritizeJobs()
+{
+	PrioritizedViewDirection = ViewDirection;
+
+	PendingActivations.RemoveAllSwap( [ this ]( const FIntPoint& ChunkCoordinate ) { return !ChunksInRange.Contains( ChunkCoordinate ); } );
+	PendingActivations.Sort( [ this ]( const FIntPoint& A, const FIntPoint& B ) { return GetChunkPriority( A ) > GetChunkPriority( B ); } );
+
+	Scheduler->Reprioritize(
+		[ this ]( const FIntPoint& ChunkCoordinate, const EChunkJobType Type, float& OutPriority )
+		{
+			if( ChunksInRange.Contains( ChunkCoordinate ) )
+			{
+				OutPriority = GetChunkPriority( ChunkCoordinate );
+				return true;
+			}
+
+			// Chunks that never finished generating are dropped right away, loaded ones keep their mesh until the hide and unload queues take it
+			FChunk* Chunk = Chunks.Find( ChunkCoordinate );
+			if( !Chunk )
+				return false;
+
+			if( Type == EChunkJobType::Voxels )
+			{
+				Chunks.Remove( ChunkCoordinate );
+				return false;
+			}
+
+			// The dropped job is redone should the chunk come back into range first
+			Chunk->DirtySections = FChunk::GetAllSections();
+			Chunk->IsMeshPending = false;
+
+			return false;
+		} );
+}
+
+void UWorldGenerationSubSystem::UpdateCollisionChunks()
+{
+	CollisionSources.RemoveAll( []( const TWeakObjectPtr< const AActor >& Source ) { return !Source.IsValid(); } );
+
+	TSet< FIntPoint > SourceChunks;
+	SourceChunks.Add( FChunk::WorldToChunk( ViewLocation ) );
+	for( const TWeakObjectPtr< const AActor >& Source: CollisionSources )
+		SourceChunks.Add( FChunk::WorldToChunk( Source->GetActorLocation() ) );
+
+	if( SourceChunks.Num() == CollisionSourceChunks.Num() && SourceChunks.Includes( CollisionSourceChunks ) )
+		return;
+
+	CollisionSourceChunks = MoveTemp( SourceChunks );
+
+	TSet< FIntPoint > NewCollisionChunks;
+	for( const FIntPoint& SourceChunk: CollisionSourceChunks )
+	{
+		for( int32 Q = -CollisionDistance; Q <= CollisionDistance; ++Q )
+		{
+			for( int32 R = FMath::Max( -CollisionDistance, -Q - CollisionDistance ); R <= FMath::Min( CollisionDistance, -Q + CollisionDistance ); ++R )
+				NewCollisionChunks.Add( SourceChunk + FIntPoint( Q, R ) );
+		}
+	}
+
+	const TSet< FIntPoint > ChangedChunks = CollisionChunks.Difference( NewCollisionChunks ).Union( NewCollisionChunks.Difference( CollisionChunks ) );
+	CollisionChunks                       = MoveTemp( NewCollisionChunks );
+
+	for( const FIntPoint& ChunkCoordinate: ChangedChunks )
+	{
+		if( FChunk* Chunk = Chunks.Find( ChunkCoordinate ) )
+			UpdateChunkCollision( *Chunk );
+	}
+}
+
+void UWorldGenerationSubSystem::UpdateChunkCollision( FChunk& Chunk ) const
+{
+	if( !Chunk.Mesh.IsValid() )
+		return;
+
+	// Coarser meshes stray too far from the voxels to stand on, those chunks collide with boxes instead
+	if( !CollisionChunks.Contains( Chunk.Coordinate ) || Chunk.Voxels.IsEmpty() )
+		Chunk.Mesh->SetCollisionType( EHexagonCollisionType::None );
+	else if( CollisionType == EHexagonCollisionType::Mesh && Chunk.Lod == 0 )
+		Chunk.Mesh->SetCollisionType( EHexagonCollisionType::Mesh );
+	else
+		Chunk.Mesh->SetCollisionBoxes( UProceduralHexagonMeshComponent::BuildColumnBoxes( Chunk.Voxels ) );
+}
+
+void UWorldGenerationSubSystem::UnloadChunk( FChunk& Chunk )
+{
+	Scheduler->Cancel( Chunk.Coordinate );
+	ChunksAwaitingNeighbours.Remove( Chunk.Coordinate );
+
+	if( Chunk.HasUnsavedChanges && !Chunk.Voxels.IsEmpty() )
+		Storage->SaveChunk( Chunk.Coordinate, MoveTemp( Chunk.Voxels ) );
+
+	if( IsValid( MeshPool ) )
+		MeshPool->Release( Chunk.Mesh.Get() );
+
+	Chunk.Mesh = nullptr;
+}
+
+void UWorldGenerationSubSystem::LoadChunkVoxels( const FIntPoint& ChunkCoordinate )
+{
+	Storage->LoadChunk( ChunkCoordinate,
+	                    [ WeakThis = TWeakObjectPtr< UWorldGenerationSubSystem >( this ), ChunkCoordinate ]( TOptional< FChunkVoxels >&& Voxels )
+	                    {
+							UWorldGenerationSubSystem* This = WeakThis.Get();
+							if( !This )
+								return;
+
+							FChunk* Chunk = This->Chunks.Find( ChunkCoordinate );
+							if( !Chunk )
+								return;
+
+							if( !Voxels.IsSet() )
+							{
+								This->GenerateChunkVoxels( ChunkCoordinate );
+								return;
+							}
+
+							Chunk->Voxels            = MoveTemp( Voxels.GetValue() );
+							Chunk->HasUnsavedChanges = false;
+							This->OnChunkVoxelsReady( *Chunk );
+						} );
+}
+
+void UWorldGenerationSubSystem::GenerateChunkVoxels( const FIntPoint& ChunkCoordinate )
+{
+	Scheduler->Add( ChunkCoordinate,
+	                EChunkJobType::Voxels,
+	                GetChunkPriority( ChunkCoordinate ),
+	                [ this, ChunkCoordinate, Pipeline = GenerationPipeline.Get() ]() -> FChunkJobScheduler::FCompletion
+	                {
+						FChunkVoxels Voxels = Pipeline->Generate( ChunkCoordinate, FChunk::GetSize(), FChunk::GetHeight() );
+
+						return [ this, ChunkCoordinate, Voxels = MoveTemp( Voxels ) ]() mutable
+						{
+							FChunk* Chunk = Chunks.Find( ChunkCoordinate );
+							if( !Chunk )
+								return;
+
+							Chunk->Voxels            = MoveTemp( Voxels );
+							Chunk->HasUnsavedChanges = true;
+							OnChunkVoxelsReady( *Chunk );
+						};
+					} );
+}
+
+void UWorldGenerationSubSystem::OnChunkVoxelsReady( FChunk& Chunk )
+{
+	// The border ring belongs to the neighbours, whose cells may now hang on to this chunk
+	Chunk.WalkGraph.Init( Chunk.Voxels );
+
+	TArray< FIntPoint > WalkColumns;
+	Chunk.Voxels.ForEachColumn( [ &WalkColumns ]( const FIntPoint& Column, TConstArrayView< FVoxelSpan > ) { WalkColumns.Add( Column ); } );
+	FChunk::ForEachBorderColumn( Chunk.Coordinate, [ &WalkColumns ]( const FIntPoint& Column ) { WalkColumns.Add( Column ); } );
+	UpdateWalkGraph( WalkColumns );
+
+	RequestChunkMesh( Chunk );
+
+	// Neighbours either waited for these voxels or were meshed with this chunk filled solid
+	for( int32 i = 0; i < CoordinateDirections.Num(); ++i )
+	{
+		const FIntPoint NeighbourCoordinate = Chunk.Coordinate + CoordinateDirections[ i ];
+
+		FChunk* Neighbour = Chunks.Find( NeighbourCoordinate );
+		if( !Neighbour || Neighbour->Voxels.IsEmpty() )
+			continue;
+
+		const uint8 NeighbourDirection = 1 << ( ( i + 3 ) % 6 );
+		if( ChunksAwaitingNeighbours.Contains( NeighbourCoordinate ) || Neighbour->MissingNeighbours & NeighbourDirection )
+			RequestChunkMesh( *Neighbour );
+	}
+}
+
+void UWorldGenerationSubSystem::RequestChunkMesh( FChunk& Chunk, const uint32 Sections )
+{
+	Chunk.IsMeshPending = true;
+	Chunk.DirtySections |= Sections;
+	++Chunk.MeshRequestId;
+
+	if( !AreNeighboursReady( Chunk.Coordinate ) )
+	{
+		ChunksAwaitingNeighbours.Add( Chunk.Coordinate );
+		return;
+	}
+
+	ChunksAwaitingNeighbours.Remove( Chunk.Coordinate );
+	GenerateChunkMesh( Chunk );
+}
+
+void UWorldGenerationSubSystem::GenerateChunkMesh( FChunk& Chunk )
+{
+	Chunk.IsMeshPending = true;
+
+	const uint32 Sections = Chunk.Lod > 0 ? FChunk::GetAllSections() : Chunk.DirtySections;
+
+	// Only the layers of the dirty sections are copied, an edit hands the worker a slab instead of the whole chunk
+	int32 Bottom = 0;
+	int32 Top    = FChunk::GetHeight();
+	if( Chunk.Lod == 0 )
+		FChunk::GetSectionLayers( Sections, Bottom, Top );
+
+	FChunkVoxels Padded = FChunk::MakePaddedVoxels( Chunk.Voxels, GatherBorder( Chunk.Coordinate, Bottom, Top, Chunk.MissingNeighbours ), Bottom, Top );
+
+	Scheduler->Add( Chunk.Coordinate,
+	                EChunkJobType::Mesh,
+	                GetChunkPriority( Chunk.Coordinate ),
+	                [ this,
+	                  ChunkCoordinate = Chunk.Coordinate,
+	                  Lod             = Chunk.Lod,
+	                  Sections,
+	                  RequestId = Chunk.MeshRequestId,
+	                  Padded    = MoveTemp( Padded ) ]() -> FChunkJobScheduler::FCompletion
+	                {
+						TArray< FHexagonMeshData > MeshSections = BuildChunkMesh( Padded, Lod, Sections );
+
+						return [ this, ChunkCoordinate, Sections, RequestId, MeshSections = MoveTemp( MeshSections ) ]() mutable
+						{
+							if( FChunk* Chunk = Chunks.Find( ChunkCoordinate ) )
+								ApplyChunkMesh( *Chunk, MoveTemp( MeshSections ), Sections, RequestId );
+						};
+					} );
+}
+
+void UWorldGenerationSubSystem::ApplyChunkMesh( FChunk& Chunk, TArray< FHexagonMeshData >&& MeshSections, const uint32 Sections, const uint32 RequestId )
+{
+	// Otherwise a newer request is waiting for its neighbours and rebuilds these sections again
+	if( RequestId == Chunk.MeshRequestId )
+	{
+		Chunk.IsMeshPending = false;
+		Chunk.DirtySections &= ~Sections;
+	}
+
+	if( !Chunk.Mesh.IsValid() )
+	{
+		// The component holding the other sections was taken while this was built
+		if( Sections != FChunk::GetAllSections() )
+		{
+			if( Chunk.IsInRange )
+				RequestChunkMesh( Chunk );
+			else
+				Chunk.DirtySections = FChunk::GetAllSections();
+
+			return;
+		}
+
+		Chunk.Mesh = AcquireMesh();
+	}
+
+	// The pool is exhausted, the mesh is rebuilt once a component frees up and the chunk is still shown
+	if( !Chunk.Mesh.IsValid() )
+		return;
+
+	Chunk.Mesh->ApplySections( MoveTemp( MeshSections ), Sections );
+	Chunk.Mesh->SetVisibility( IsVisible( Chunk ) );
+	UpdateChunkCollision( Chunk );
+
+	++StreamingStats.NumUploaded;
+}
+
+TArray< FHexagonMeshData > UWorldGenerationSubSystem::BuildChunkMesh( const FChunkVoxels& Padded, const int32 Lod, const uint32 Sections )
+{
+	TArray< FHexagonMeshData > MeshSections;
+	if( Lod > 0 )
+	{
+		MeshSections.Add( UProceduralHexagonMeshComponent::BuildLodMesh( Padded, 1 << Lod ) );
+		return MeshSections;
+	}
+
+	const int32 SectionHeight = FChunk::GetSectionHeight();
+	const int32 PaddedBottom  = Padded.GetOrigin().Z;
+
+	MeshSections.SetNum( FChunk::GetNumSections() );
+	for( int32 i = 0; i < MeshSections.Num(); ++i )
+	{
+		if( Sections & 1u << i )
+			MeshSections[ i ] = UProceduralHexagonMeshComponent::BuildMesh< FChunkMeshPolicy >( Padded, i * SectionHeight - PaddedBottom, ( i + 1 ) * SectionHeight - PaddedBottom );
+	}
+
+	return MeshSections;
+}
+
+TArray< EVoxelType > UWorldGenerationSubSystem::GatherBorder( const FIntPoint& ChunkCoordinate, const int32 Bottom, const int32 Top, uint8& OutMissingNeighbours ) const
+{
+	const int32 Height = Top - Bottom;
+
+	TArray< EVoxelType > Border;
+	Border.Reserve( ( FChunk::GetSize() + 1 ) * 4 * Height );
+
+	OutMissingNeighbours = 0;
+	for( int32 i = 0; i < CoordinateDirections.Num(); ++i )
+	{
+		const FChunk* Neighbour = Chunks.Find( ChunkCoordinate + CoordinateDirections[ i ] );
+		if( !Neighbour || Neighbour->Voxels.IsEmpty() )
+			OutMissingNeighbours |= 1 << i;
+	}
+
+	const FChunk* Neighbour = nullptr;
+	FChunk::ForEachBorderColumn( ChunkCoordinate,
+	                             [ & ]( const FIntPoint& ColumnCoordinate )
+	                             {
+									 const int32                    Offset = Border.AddUninitialized( Height );
+									 const TArrayView< EVoxelType > ColumnTypes( Border.GetData() + Offset, Height );
+
+									 if( !Neighbour || !Neighbour->Voxels.IsColumnInside( ColumnCoordinate ) )
+										 Neighbour = Chunks.Find( FChunk::VoxelToChunk( FIntVector( ColumnCoordinate.X, ColumnCoordinate.Y, 0 ) ) );
+
+									 // Faces are never built against chunks that are not there
+									 if( Neighbour && !Neighbour->Voxels.IsEmpty() && Neighbour->Voxels.GetExtent().Z == FChunk::GetHeight() )
+										 Neighbour->Voxels.GetColumnTypes( ColumnCoordinate, Bottom, ColumnTypes );
+									 else
+										 for( EVoxelType& Type: ColumnTypes )
+											 Type = EVoxelType::Stone;
+								 } );
+
+	return Border;
+}
+
+void UWorldGenerationSubSystem::UpdateWalkGraph( const TConstArrayView< FIntPoint > Columns )
+{
+	const auto FindWalkGraph = [ this ]( const FIntPoint& Column ) -> FChunkWalkGraph*
+	{
+		FChunk* Chunk = Chunks.Find( FChunk::VoxelToChunk( FIntVector( Column.X, Column.Y, 0 ) ) );
+		return Chunk && Chunk->WalkGraph.IsInside( Column ) ? &Chunk->WalkGraph : nullptr;
+	};
+
+	FWorldVoxelQuery Query( this );
+
+	TSet< FIntPoint > EdgeColumns;
+	EdgeColumns.Reserve( Columns.Num() + 6 );
+	for( const FIntPoint& Column: Columns )
+	{
+		if( FChunkWalkGraph* WalkGraph = FindWalkGraph( Column ) )
+			WalkGraph->UpdateCells( Column, Query );
+
+		EdgeColumns.Add( Column );
+		for( const FIntPoint& Direction: CoordinateDirections )
+			EdgeColumns.Add( Column + Direction );
+	}
+
+	TSet< FIntPoint, DefaultKeyFuncs< FIntPoint >, TInlineSetAllocator< 8 > > ChangedChunks;
+	for( const FIntPoint& Column: EdgeColumns )
+	{
+		if( FChunkWalkGraph* WalkGraph = FindWalkGraph( Column ) )
+		{
+			WalkGraph->UpdateEdges( Column, Query );
+			ChangedChunks.Add( FChunk::VoxelToChunk( FIntVector( Column.X, Column.Y, 0 ) ) );
+		}
+	}
+
+	for( const FIntPoint& ChunkCoordinate: ChangedChunks )
+		OnWalkGraphChanged.Broadcast( ChunkCoordinate );
+}
+
+bool UWorldGenerationSubSystem::AreNeighboursReady( const FIntPoint& ChunkCoordinate ) const
+{
+	for( const FIntPoint& Direction: CoordinateDirections )
+	{
+		const FIntPoint NeighbourCoordinate = ChunkCoordinate + Direction;
+		if( !ChunksInRange.Contains( NeighbourCoordinate ) )
+			continue;
+
+		const FChunk* Neighbour = Chunks.Find( NeighbourCoordinate );
+		if( !Neighbour || Neighbour->Voxels.IsEmpty() )
+			return false;
+	}
 
-	const FVector WorldLocation = AChunk::ChunkToWorld( Chunk );
-	AChunk*       ChunkActor    = GetWorld()->SpawnActor< AChunk >( ChunkClass, FTransform( WorldLocation ) );
-	ChunkActor->Generate( Chunk );
-	ChunkActor->SetVisible();
-	Chunks.Add( Chunk, ChunkActor );
 	return true;
 }
-bool UWorldGenerationSubSystem::IsWithinDistance( const FIntPoint& Current, const FIntPoint& Other ) const
+
+UProceduralHexagonMeshComponent* UWorldGenerationSubSystem::AcquireMesh()
 {
-	const int32 SCurrent = -Current.X - Current.Y;
-	const int32 SOther   = -Other.X - Other.Y;
-	const int32 Distance = ( FMath::Abs( Current.X - Other.X ) + FMath::Abs( Current.Y - Other.Y ) + FMath::Abs( SCurrent - SOther ) ) / 2;
+	if( !IsValid( MeshPool ) )
+		return nullptr;
+
+	if( UProceduralHexagonMeshComponent* MeshComponent = MeshPool->Acquire() )
+		return MeshComponent;
+
+	// Take the component of the chunk that has been hidden the longest
+	FChunk* OldestChunk = nullptr;
+	for( TPair< FIntPoint, FChunk >& Chunk: Chunks )
+	{
+		if( !Chunk.Value.Mesh.IsValid() || IsVisible( Chunk.Value ) )
+			continue;
+
+		if( !OldestChunk || Chunk.Value.LeftRangeTime < OldestChunk->LeftRangeTime )
+			OldestChunk = &Chunk.Value;
+	}
 
-	return Distance < GenerationDistance;
-}
\ No newline at end of file
+	if( !OldestChunk )
+		return nullptr;
+
+	UProceduralHexagonMeshComponent* MeshComponent = OldestChunk->Mesh.Get();
+	OldestChunk->Mesh                              = nullptr;
+
+	MeshComponent->ClearMesh();
+	return MeshComponent;
+}
+
+float UWorldGenerationSubSystem::GetChunkPriority( const FIntPoint& ChunkCoordinate ) const
+{
+	const int32   Size     = FChunk::GetSize();
+	const FVector Center   = FHexagonVoxel::VoxelToWorld( FIntVector( ChunkCoordinate.X * Size + Size / 2, ChunkCoordinate.Y * Size + Size / 2, 0 ) );
+	const FVector Offset   = ( Center - ViewLocation ) * FVector( 1, 1, 0 );
+	const float   Distance = Offset.Size();
+
+	// Chunks in front of the view come first, the ones behind are postponed
+	const float Facing = Distance > 0 ? FVector::DotProduct( Offset / Distance, ViewDirection ) : 1;
+	return Distance * ( 1 - ViewDirectionWeight * Facing );
+}
+
+int32 UWorldGenerationSubSystem::GetChunkLod( const FIntPoint& ChunkCoordinate ) const
+{
+	const FIntPoint Center   = StreamingCenter.Get( ChunkCoordinate );
+	const FIntPoint Offset   = ChunkCoordinate - Center;
+	const int32     Distance = ( FMath::Abs( Offset.X ) + FMath::Abs( Offset.Y ) + FMath::Abs( Offset.X + Offset.Y ) ) / 2;
+
+	int32 Lod = 0;
+	while( Lod < LodDistanceFractions.Num() && Distance >= FMath::RoundToInt32( LodDistanceFractions[ Lod ] * GenerationDistance ) )
+		++Lod;
+
+	return Lod;
+}
+
+bool UWorldGenerationSubSystem::IsVisible( const FChunk& Chunk ) const
+{
+	return Chunk.IsInRange || GetWorld()->GetTimeSeconds() - Chunk.LeftRangeTime <= HideDelay;
+}
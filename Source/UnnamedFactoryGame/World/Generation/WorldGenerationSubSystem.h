@@ -3,44 +3,233 @@
 #pragma once
 
 #include "Chunk.h"
+#include "ChunkJobScheduler.h"
+#include "ChunkRegionStorage.h"
+#include "Containers/RingBuffer.h"
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "WorldVoxelQuery.h"
 
 #include "WorldGenerationSubSystem.generated.h"
 
+class AChunkMeshPool;
+class UWorldGenerationPipeline;
+
+struct FChunkStreamingStats
+{
+	/** Chunks in range waiting to be created */
+	int32 NumPendingActivations = 0;
+
+	int32 NumPendingJobs  = 0;
+	int32 NumRunningJobs  = 0;
+	int32 NumFinishedJobs = 0;
+
+	/** Work done during the last tick */
+	int32  NumActivated = 0;
+	int32  NumUploaded  = 0;
+	double Time         = 0;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam( FOnWalkGraphChanged, const FIntPoint& /* ChunkCoordinate */ );
+DECLARE_MULTICAST_DELEGATE_OneParam( FOnChunkUnloaded, const FIntPoint& /* ChunkCoordinate */ );
+
 /**
  * 
  */
-UCLASS()
+UCLASS( Config = Game )
 class UNNAMEDFACTORYGAME_API UWorldGenerationSubSystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 
 public:
-	UWorldGenerationSubSystem();
-
 	static UWorldGenerationSubSystem* Get( const UObject* WorldContextObject ) { return WorldContextObject->GetWorld()->GetSubsystem< UWorldGenerationSubSystem >(); }
 
+	virtual void Initialize( FSubsystemCollectionBase& Collection ) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay( UWorld& InWorld ) override;
+
 	virtual TStatId GetStatId() const override { return TStatId(); }
 
 	virtual void Tick( float DeltaTime ) override;
 
-	AChunk* GetChunk( const FVector& WorldLocation );
-	AChunk* GetChunk( const FIntVector& VoxelCoordinate );
-	AChunk* GetChunk( const FIntPoint& ChunkCoordinate );
+	const FChunk* GetChunk( const FVector& WorldLocation ) const;
+	const FChunk* GetChunk( const FIntVector& VoxelCoordinate ) const;
+	const FChunk* GetChunk( const FIntPoint& ChunkCoordinate ) const;
+
+	bool GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel ) const;
+	bool GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel ) const;
+
+	/** Changes a loaded voxel and updates every chunk that stores a copy of it */
+	bool SetVoxel( const FIntVector& VoxelCoordinate, EVoxelType Type );
+
+	FVoxelView GetVoxelView( const FVector& WorldLocation ) const { return FWorldVoxelQuery( this ).GetView( WorldLocation ); }
+	FVoxelView GetVoxelView( const FIntVector& VoxelCoordinate ) const { return FWorldVoxelQuery( this ).GetView( VoxelCoordinate ); }
+
+	int32 GetVoxelTypes( TConstArrayView< FIntVector > Coordinates, TArrayView< EVoxelType > OutTypes, TBitArray<>* OutLoaded = nullptr ) const
+	{
+		return FWorldVoxelQuery( this ).GetTypes( Coordinates, OutTypes, OutLoaded );
+	}
 
-	bool GetVoxel( const FVector& WorldLocation, FHexagonVoxel& OutVoxel );
-	bool GetVoxel( const FIntVector& VoxelCoordinate, FHexagonVoxel& OutVoxel );
+	const FChunkStreamingStats& GetStreamingStats() const { return StreamingStats; }
+
+	/** Keeps the chunks within CollisionDistance of Actor collidable, the player always does */
+	void AddCollisionSource( const AActor* Actor );
+	void RemoveCollisionSource( const AActor* Actor );
+
+	/** Broadcast for every chunk whose walk graph was built or patched, not when it unloads */
+	FOnWalkGraphChanged OnWalkGraphChanged;
+
+	/** Broadcast once a chunk has left the world, its voxels and walk graph are gone */
+	FOnChunkUnloaded OnChunkUnloaded;
 
 private:
-	bool UpdateChunk( const FIntPoint& Chunk, bool OnlyVisibility );
+	void UpdateStreaming( const FIntPoint& Center );
+	void EnterRange( const FIntPoint& ChunkCoordinate );
+	void LeaveRange( const FIntPoint& ChunkCoordinate, double Time );
+	void ActivatePendingChunks( double EndTime );
+	void UpdateOutOfRangeChunks();
+	void ReprioritizeJobs();
+
+	/** Recomputes which chunks collide once a collision source has moved to another chunk */
+	void UpdateCollisionChunks();
+	void UpdateChunkCollision( FChunk& Chunk ) const;
+
+	void UnloadChunk( FChunk& Chunk );
+
+	void LoadChunkVoxels( const FIntPoint& ChunkCoordinate );
+	void GenerateChunkVoxels( const FIntPoint& ChunkCoordinate );
+	void OnChunkVoxelsReady( FChunk& Chunk );
+	/** Marks Sections dirty and rebuilds every dirty section of the chunk */
+	void RequestChunkMesh( FChunk& Chunk, uint32 Sections = FChunk::GetAllSections() );
+	void GenerateChunkMesh( FChunk& Chunk );
+	void ApplyChunkMesh( FChunk& Chunk, TArray< FHexagonMeshData >&& MeshSections, uint32 Sections, uint32 RequestId );
+
+	/**
+	 * Builds the sections whose bit is set from the chunk padded over at least their layers, detail levels above 0 give a single section replacing all others.
+	 * Those need the padded chunk's full height.
+	 */
+	static TArray< FHexagonMeshData > BuildChunkMesh( const FChunkVoxels& Padded, int32 Lod, uint32 Sections );
+
+	/** Copies the local layers [Bottom, Top) of the columns around the chunk from its loaded neighbours, missing ones are filled solid */
+	TArray< EVoxelType > GatherBorder( const FIntPoint& ChunkCoordinate, int32 Bottom, int32 Top, uint8& OutMissingNeighbours ) const;
+
+	/** Recomputes the walkable cells of Columns and the edges of every column next to them, in whichever chunk holds them */
+	void UpdateWalkGraph( TConstArrayView< FIntPoint > Columns );
+
+	/** True when no neighbour the chunk waits for is still loading */
+	bool AreNeighboursReady( const FIntPoint& ChunkCoordinate ) const;
+
+	UProceduralHexagonMeshComponent* AcquireMesh();
+
+	float GetChunkPriority( const FIntPoint& ChunkCoordinate ) const;
+	int32 GetChunkLod( const FIntPoint& ChunkCoordinate ) const;
+
+	bool IsVisible( const FChunk& Chunk ) const;
+
+	TMap< FIntPoint, FChunk > Chunks;
+
+	TUniquePtr< FChunkRegionStorage > Storage;
+
+	/** Released before the pipeline its jobs read */
+	TUniquePtr< FChunkJobScheduler > Scheduler;
+
+	FVector ViewLocation             = FVector::ZeroVector;
+	FVector ViewDirection            = FVector::ForwardVector;
+	FVector PrioritizedViewDirection = FVector::ForwardVector;
+
+	/** Chunk the player was in when the streamed range was last computed */
+	TOptional< FIntPoint > StreamingCenter;
+
+	/** Chunks within GenerationDistance of StreamingCenter */
+	TSet< FIntPoint > ChunksInRange;
+
+	/** Chunks whose mesh is held back until their neighbours have voxels */
+	TSet< FIntPoint > ChunksAwaitingNeighbours;
+
+	/** Chunks in range without a record yet, most important last */
+	TArray< FIntPoint > PendingActivations;
+
+	TArray< TWeakObjectPtr< const AActor > > CollisionSources;
+
+	/** Chunks holding the player or a collision source when CollisionChunks was computed */
+	TSet< FIntPoint > CollisionSourceChunks;
+
+	/** Chunks within CollisionDistance of a collision source */
+	TSet< FIntPoint > CollisionChunks;
+
+	/** Chunks that left the range with the time they left, oldest first */
+	TRingBuffer< TPair< FIntPoint, double > > HideQueue;
+	TRingBuffer< TPair< FIntPoint, double > > UnloadQueue;
+
+	/** Cosine of the view rotation that triggers a new job ordering without a change of chunk */
+	static constexpr float ReprioritizeViewDot = .9f;
+
+	FChunkStreamingStats StreamingStats;
+
+	UPROPERTY( Transient )
+	TObjectPtr< AChunkMeshPool > MeshPool;
+
+	UPROPERTY( Transient )
+	TObjectPtr< UMaterialInterface > ChunkMaterial;
+
+	UPROPERTY( Transient )
+	TObjectPtr< UWorldGenerationPipeline > GenerationPipeline;
+
+	UPROPERTY( Config )
+	int32 ChunkSize = 16;
+	UPROPERTY( Config )
+	int32 ChunkHeight = 32;
+
+	/** Layers per chunk mesh section, an edit only rebuilds the sections around it */
+	UPROPERTY( Config )
+	int32 MeshSectionHeight = 8;
+
+	/** Falls back to UWorldGenerationPipeline::CreateDefault when not set */
+	UPROPERTY( Config )
+	TSoftObjectPtr< UWorldGenerationPipeline > GenerationPipelineAsset;
+
+	/** Material of every chunk mesh, the engine default when not set */
+	UPROPERTY( Config )
+	TSoftObjectPtr< UMaterialInterface > ChunkMaterialAsset;
+
+	/** Coarser detail levels keep the far rings within the triangle budget of a full detail range of 8 */
+	UPROPERTY( Config )
+	int32 GenerationDistance = 16;
+
+	/** Chunk distance around the player and the collision sources where chunks collide */
+	UPROPERTY( Config )
+	int32 CollisionDistance = 1;
+
+	/** Chunks at a coarser detail level than 0 always collide with Boxes */
+	UPROPERTY( Config )
+	EHexagonCollisionType CollisionType = EHexagonCollisionType::Mesh;
+
+	/**
+	 * Fraction of GenerationDistance where each coarser detail level starts, level i samples every 2^i-th column.
+	 * Levels at a fraction of 1 or more are never reached.
+	 */
+	UPROPERTY( Config )
+	TArray< float > LodDistanceFractions = { .25f, .5f };
+
+	/** Generation and meshing jobs running at once, 0 uses all but one worker thread */
+	UPROPERTY( Config )
+	int32 MaxConcurrentJobs = 0;
 
-	bool IsWithinDistance( const FIntPoint& Current, const FIntPoint& Other ) const;
+	/** How strongly chunks in front of the view are preferred over equally distant ones behind, 0 to 1 */
+	UPROPERTY( Config )
+	float ViewDirectionWeight = .5f;
 
-	TMap< FIntPoint, TObjectPtr< AChunk > > Chunks;
+	/** Milliseconds per frame the game thread spends creating chunks and uploading their meshes and collision */
+	UPROPERTY( Config )
+	float StreamingFrameBudget = 4;
 
-	UPROPERTY()
-	TSubclassOf< AChunk > ChunkClass;
+	/** Pooled mesh components per chunk within GenerationDistance, the surplus covers the chunks fading out */
+	UPROPERTY( Config )
+	float MeshPoolScale = 1.5f;
 
-	int32 GenerationDistance = 8;
+	/** Seconds a chunk stays shown and loaded after leaving GenerationDistance */
+	UPROPERTY( Config )
+	float HideDelay = 1;
+	UPROPERTY( Config )
+	float UnloadDelay = 30;
 };
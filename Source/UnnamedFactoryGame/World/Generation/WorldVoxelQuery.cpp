@@ -0,0 +1,93 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorldVoxelQuery.h"
+
+#include "WorldGenerationSubSystem.h"
+
+FWorldVoxelQuery::FWorldVoxelQuery( const UWorldGenerationSubSystem* InWorldGenerationSubSystem )
+	: WorldGenerationSubSystem( InWorldGenerationSubSystem )
+{}
+
+const FChunkVoxels* FWorldVoxelQuery::FindVoxels( const FIntVector& VoxelCoordinate )
+{
+	UpdateCache( VoxelCoordinate );
+
+	if( !CachedChunk || !CachedChunk->GetVoxels().IsInside( VoxelCoordinate ) )
+		return nullptr;
+
+	return &CachedChunk->GetVoxels();
+}
+
+const FWalkCell* FWorldVoxelQuery::FindWalkCell( const FIntVector& VoxelCoordinate )
+{
+	UpdateCache( VoxelCoordinate );
+
+	return CachedChunk ? CachedChunk->WalkGraph.Find( VoxelCoordinate ) : nullptr;
+}
+
+bool FWorldVoxelQuery::GetType( const FIntVector& VoxelCoordinate, EVoxelType& OutType )
+{
+	const FChunkVoxels* Voxels = FindVoxels( VoxelCoordinate );
+	if( !Voxels )
+		return false;
+
+	OutType = Voxels->GetType( VoxelCoordinate );
+	return true;
+}
+
+int32 FWorldVoxelQuery::GetTypes( const TConstArrayView< FIntVector > Coordinates, const TArrayView< EVoxelType > OutTypes, TBitArray<>* OutLoaded )
+{
+	check( Coordinates.Num() == OutTypes.Num() );
+
+	if( OutLoaded )
+		OutLoaded->Init( false, Coordinates.Num() );
+
+	int32 Loaded = 0;
+	for( int32 i = 0; i < Coordinates.Num(); ++i )
+	{
+		const FChunkVoxels* Voxels = FindVoxels( Coordinates[ i ] );
+		OutTypes[ i ]              = Voxels ? Voxels->GetType( Coordinates[ i ] ) : EVoxelType::Air;
+
+		if( !Voxels )
+			continue;
+
+		if( OutLoaded )
+			( *OutLoaded )[ i ] = true;
+
+		++Loaded;
+	}
+
+	return Loaded;
+}
+
+uint64 FWorldVoxelQuery::GetStencil( const FIntVector& Center, const TConstArrayView< FIntVector > Offsets, const TArrayView< EVoxelType > OutTypes )
+{
+	check( Offsets.Num() <= 64 && Offsets.Num() == OutTypes.Num() );
+
+	uint64 LoadedMask = 0;
+	for( int32 i = 0; i < Offsets.Num(); ++i )
+	{
+		const FIntVector    VoxelCoordinate = Center + Offsets[ i ];
+		const FChunkVoxels* Voxels          = FindVoxels( VoxelCoordinate );
+		OutTypes[ i ]                       = Voxels ? Voxels->GetType( VoxelCoordinate ) : EVoxelType::Air;
+
+		if( Voxels )
+			LoadedMask |= static_cast< uint64 >( 1 ) << i;
+	}
+
+	return LoadedMask;
+}
+
+void FWorldVoxelQuery::UpdateCache( const FIntVector& VoxelCoordinate )
+{
+	const bool InCachedChunk = VoxelCoordinate.X >= CachedMin.X && VoxelCoordinate.Y >= CachedMin.Y && VoxelCoordinate.X < CachedMax.X && VoxelCoordinate.Y < CachedMax.Y;
+	if( InCachedChunk )
+		return;
+
+	const FIntPoint ChunkCoordinate = FChunk::VoxelToChunk( VoxelCoordinate );
+	const FChunk*   Chunk           = WorldGenerationSubSystem ? WorldGenerationSubSystem->GetChunk( ChunkCoordinate ) : nullptr;
+
+	CachedMin   = ChunkCoordinate * FChunk::GetSize();
+	CachedMax   = CachedMin + FIntPoint( FChunk::GetSize() );
+	CachedChunk = Chunk && !Chunk->GetVoxels().IsEmpty() ? Chunk : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ChunkVoxels.h"
+#include "CoreMinimal.h"
+#include "HexagonVoxel.h"
+
+class UWorldGenerationSubSystem;
+struct FChunk;
+struct FWalkCell;
+
+/**
+ * Read only handle to a voxel inside a loaded chunk, valid until the chunk is regenerated or unloaded.
+ */
+struct FVoxelView
+{
+	const FChunkVoxels* Voxels     = nullptr;
+	FIntVector          Coordinate = FIntVector::ZeroValue;
+
+	bool IsValid() const { return Voxels != nullptr; }
+
+	EVoxelType GetType() const { return Voxels ? Voxels->GetType( Coordinate ) : EVoxelType::Air; }
+	bool       IsSolid() const { return GetType() != EVoxelType::Air; }
+
+	FVector       GetWorldLocation() const { return FHexagonVoxel::VoxelToWorld( Coordinate ); }
+	FHexagonVoxel ToVoxel() const { return FHexagonVoxel( Coordinate, GetType() ); }
+};
+
+/**
+ * Short lived, game thread only reader over the loaded chunks that memoises the last chunk it hit.
+ * Meant to be created on the stack for one batch of queries such as a single path search.
+ */
+class UNNAMEDFACTORYGAME_API FWorldVoxelQuery
+{
+public:
+	explicit FWorldVoxelQuery( const UWorldGenerationSubSystem* InWorldGenerationSubSystem );
+
+	const FChunkVoxels* FindVoxels( const FIntVector& VoxelCoordinate );
+
+	FVoxelView GetView( const FIntVector& VoxelCoordinate ) { return FVoxelView{ .Voxels = FindVoxels( VoxelCoordinate ), .Coordinate = VoxelCoordinate }; }
+	FVoxelView GetView( const FVector& WorldLocation ) { return GetView( FHexagonVoxel::WorldToVoxel( WorldLocation ) ); }
+
+	bool GetType( const FIntVector& VoxelCoordinate, EVoxelType& OutType );
+
+	/** Null when the voxel is not walkable or its chunk is not loaded */
+	const FWalkCell* FindWalkCell( const FIntVector& VoxelCoordinate );
+
+	/**
+	 * Resolves every coordinate, unloaded ones are reported as air and cleared in OutLoaded when given.
+	 * @return Number of coordinates that were loaded
+	 */
+	int32 GetTypes( TConstArrayView< FIntVector > Coordinates, TArrayView< EVoxelType > OutTypes, TBitArray<>* OutLoaded = nullptr );
+
+	/**
+	 * Resolves a neighbourhood stencil of up to 64 offsets around Center.
+	 * @return Bit mask with bit i set when Center + Offsets[ i ] is loaded
+	 */
+	uint64 GetStencil( const FIntVector& Center, TConstArrayView< FIntVector > Offsets, TArrayView< EVoxelType > OutTypes );
+
+private:
+	const UWorldGenerationSubSystem* WorldGenerationSubSystem = nullptr;
+
+	void UpdateCache( const FIntVector& VoxelCoordinate );
+
+	const FChunk* CachedChunk = nullptr;
+	FIntPoint     CachedMin   = FIntPoint::ZeroValue;
+	FIntPoint     CachedMax   = FIntPoint::ZeroValue;
+};
@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkPortalGraph.h"
+
+#include "ChunkWalkGraph.h"
+#include "PathSearch.h"
+#include "UnnamedFactoryGame/World/Generation/Chunk.h"
+#include "UnnamedFactoryGame/World/Generation/HexagonVoxel.h"
+#include "UnnamedFactoryGame/World/Generation/WorldVoxelQuery.h"
+#include "WalkGraphSearch.h"
+
+void FChunkPortalGraph::Build( const FIntPoint&      ChunkCoordinate,
+                              const FChunkWalkGraph& WalkGraph,
+                              FWorldVoxelQuery&      Query,
+                              FPathSearch&           Search,
+                              const int32            MaxPortalWidth )
+{
+	Portals.Reset();
+	PortalByCell.Reset();
+	Segments.Reset();
+
+	const auto IsInside = [ &ChunkCoordinate ]( const FIntVector& VoxelCoordinate ) { return FChunk::VoxelToChunk( VoxelCoordinate ) == ChunkCoordinate; };
+
+	// Only horizontal steps leave a chunk, in either direction
+	const auto IsBorderCell = [ & ]( const FIntVector& Cell, const uint8 Edges )
+	{
+		for( int32 Direction = 0; Direction < CoordinateDirections.Num(); ++Direction )
+		{
+			const FIntVector Neighbour = Cell + HexagonDirections[ Direction ];
+			if( IsInside( Neighbour ) )
+				continue;
+
+			if( Edges >> Direction & 1 )
+				return true;
+
+			const int32      Opposite      = ( Direction + 3 ) % CoordinateDirections.Num();
+			const FWalkCell* NeighbourCell = Query.FindWalkCell( Neighbour );
+			if( NeighbourCell && NeighbourCell->Edges >> Opposite & 1 )
+				return true;
+		}
+
+		return false;
+	};
+
+	const int32     Size = FChunk::GetSize();
+	const FIntPoint Min  = ChunkCoordinate * Size;
+
+	TMap< FIntVector, uint8 > BorderCells;
+	for( int32 Q = Min.X; Q < Min.X + Size; ++Q )
+	{
+		for( int32 R = Min.Y; R < Min.Y + Size; ++R )
+		{
+			if( Q != Min.X && R != Min.Y && Q != Min.X + Size - 1 && R != Min.Y + Size - 1 )
+				continue;
+
+			for( const FWalkCell& Cell: WalkGraph.GetCells( FIntPoint( Q, R ) ) )
+			{
+				const FIntVector Coordinate( Q, R, WalkGraph.GetOriginZ() + Cell.Z );
+				if( IsBorderCell( Coordinate, Cell.Edges ) )
+					BorderCells.Add( Coordinate, Cell.Edges );
+			}
+		}
+	}
+
+	// Horizontal directions pair up three apart, up and down are the last two
+	const auto GetOpposite = []( const int32 Direction ) { return Direction < CoordinateDirections.Num() ? ( Direction + 3 ) % CoordinateDirections.Num() : 13 - Direction; };
+
+	// Border cells joined by a walk edge either way are grouped breadth first, so a group stays compact and its middle cell is a fair stand in
+	TArray< TArray< FIntVector, TInlineAllocator< 4 > > > Groups;
+	for( const TPair< FIntVector, uint8 >& Seed: BorderCells )
+	{
+		if( PortalByCell.Contains( Seed.Key ) )
+			continue;
+
+		const int32 PortalIndex = Portals.AddDefaulted();
+
+		TArray< FIntVector, TInlineAllocator< 4 > >& Group = Groups.AddDefaulted_GetRef();
+		Group.Add( Seed.Key );
+		PortalByCell.Add( Seed.Key, PortalIndex );
+
+		for( int32 i = 0; i < Group.Num() && Group.Num() < MaxPortalWidth; ++i )
+		{
+			const uint8 Edges = BorderCells[ Group[ i ] ];
+			for( int32 Direction = 0; Direction < HexagonDirections.Num() && Group.Num() < MaxPortalWidth; ++Direction )
+			{
+				const FIntVector Neighbour      = Group[ i ] + HexagonDirections[ Direction ];
+				const uint8*     NeighbourEdges = BorderCells.Find( Neighbour );
+				if( !NeighbourEdges || PortalByCell.Contains( Neighbour ) )
+					continue;
+
+				if( ( Edges >> Direction & 1 ) == 0 && ( *NeighbourEdges >> GetOpposite( Direction ) & 1 ) == 0 )
+					continue;
+
+				Group.Add( Neighbour );
+				PortalByCell.Add( Neighbour, PortalIndex );
+			}
+		}
+
+		Portals[ PortalIndex ].Coordinate = Group[ Group.Num() / 2 ];
+	}
+
+	for( int32 PortalIndex = 0; PortalIndex < Portals.Num(); ++PortalIndex )
+	{
+		FChunkPortal& Portal = Portals[ PortalIndex ];
+		FWalkGraphSearch::Flood( Search, Query, Portal.Coordinate, false, IsInside );
+
+		Portal.Costs.Reset( Portals.Num() );
+		for( const FChunkPortal& Other: Portals )
+			Portal.Costs.Add( Search.Costs[ Search.FindOrAdd( Other.Coordinate ) ] );
+
+		// Grouping follows edges either way, a one way drop can leave a member the stand in does not reach
+		for( const FIntVector& Cell: Groups[ PortalIndex ] )
+		{
+			const float CellCost = Search.Costs[ Search.FindOrAdd( Cell ) ];
+			if( CellCost == MAX_flt )
+				continue;
+
+			const uint8 Edges = BorderCells[ Cell ];
+			for( int32 Direction = 0; Direction < CoordinateDirections.Num(); ++Direction )
+			{
+				const FIntVector Neighbour = Cell + HexagonDirections[ Direction ];
+				if( Edges >> Direction & 1 && !IsInside( Neighbour ) )
+					Portal.Exits.Emplace( Neighbour, CellCost + 1 );
+			}
+		}
+	}
+}
+
+int32 FChunkPortalGraph::FindPortal( const FIntVector& BorderCell ) const
+{
+	const int32* PortalIndex = PortalByCell.Find( BorderCell );
+	return PortalIndex ? *PortalIndex : INDEX_NONE;
+}
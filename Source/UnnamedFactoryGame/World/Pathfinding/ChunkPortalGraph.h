@@ -0,0 +1,43 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FWorldVoxelQuery;
+struct FChunkWalkGraph;
+struct FPathSearch;
+
+/**
+ * Group of up to a few walk cells along a chunk border, joined by walk edges, that step into or are entered from a neighbouring chunk.
+ * Coordinate stands for the whole group in the hierarchical search.
+ */
+struct FChunkPortal
+{
+	FIntVector Coordinate = FIntVector::ZeroValue;
+
+	/** Cells of neighbouring chunks the group steps into, with the cost of walking there from Coordinate */
+	TArray< TPair< FIntVector, float >, TInlineAllocator< 4 > > Exits;
+
+	/** Cost to every portal of the chunk in FChunkPortalGraph::Portals order, MAX_flt when it cannot be reached inside the chunk */
+	TArray< float > Costs;
+};
+
+/**
+ * Abstract graph of one loaded chunk for hierarchical pathfinding: its border portals and what it costs to cross the chunk between them.
+ */
+struct UNNAMEDFACTORYGAME_API FChunkPortalGraph
+{
+	/** Rebuilds everything from the walk graph of a loaded chunk, Search must not be in use by the caller */
+	void Build( const FIntPoint& ChunkCoordinate, const FChunkWalkGraph& WalkGraph, FWorldVoxelQuery& Query, FPathSearch& Search, int32 MaxPortalWidth );
+
+	/** Portal whose group holds the border cell, INDEX_NONE when it is not part of one */
+	int32 FindPortal( const FIntVector& BorderCell ) const;
+
+	TArray< FChunkPortal > Portals;
+
+	TMap< FIntVector, int32 > PortalByCell;
+
+	/** Refined paths between two portals of the chunk, filled by the queries that needed them and cleared with the walk graph */
+	TMap< FIntPoint, TArray< FIntVector > > Segments;
+};
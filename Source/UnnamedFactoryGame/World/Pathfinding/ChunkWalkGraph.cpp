@@ -0,0 +1,136 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkWalkGraph.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Sort.h"
+#include "UnnamedFactoryGame/World/Generation/ChunkVoxels.h"
+#include "UnnamedFactoryGame/World/Generation/HexagonVoxel.h"
+#include "UnnamedFactoryGame/World/Generation/WorldVoxelQuery.h"
+
+void FChunkWalkGraph::Init( const FChunkVoxels& Voxels )
+{
+	Min     = FIntPoint( Voxels.GetOrigin().X, Voxels.GetOrigin().Y );
+	Extent  = FIntPoint( Voxels.GetExtent().X, Voxels.GetExtent().Y );
+	OriginZ = Voxels.GetOrigin().Z;
+
+	Columns.Reset();
+	Columns.SetNum( Extent.X * Extent.Y );
+}
+
+bool FChunkWalkGraph::IsInside( const FIntPoint& ColumnCoordinate ) const
+{
+	const FIntPoint Local = ColumnCoordinate - Min;
+	return !Columns.IsEmpty() && Local.X >= 0 && Local.Y >= 0 && Local.X < Extent.X && Local.Y < Extent.Y;
+}
+
+const FWalkCell* FChunkWalkGraph::Find( const FIntVector& VoxelCoordinate ) const
+{
+	const FColumn* Cells = FindColumn( FIntPoint( VoxelCoordinate.X, VoxelCoordinate.Y ) );
+	if( !Cells )
+		return nullptr;
+
+	const int32 Z     = VoxelCoordinate.Z - OriginZ;
+	const int32 Index = Algo::LowerBoundBy( *Cells, Z, []( const FWalkCell& Cell ) { return static_cast< int32 >( Cell.Z ); } );
+	return Cells->IsValidIndex( Index ) && ( *Cells )[ Index ].Z == Z ? &( *Cells )[ Index ] : nullptr;
+}
+
+TConstArrayView< FWalkCell > FChunkWalkGraph::GetCells( const FIntPoint& ColumnCoordinate ) const
+{
+	const FColumn* Cells = FindColumn( ColumnCoordinate );
+	return Cells ? TConstArrayView< FWalkCell >( *Cells ) : TConstArrayView< FWalkCell >();
+}
+
+void FChunkWalkGraph::UpdateCells( const FIntPoint& ColumnCoordinate, FWorldVoxelQuery& Query )
+{
+	FColumn* Cells = FindColumn( ColumnCoordinate );
+	if( !Cells )
+		return;
+
+	Cells->Reset();
+
+	const FChunkVoxels* Voxels = Query.FindVoxels( FIntVector( ColumnCoordinate.X, ColumnCoordinate.Y, OriginZ ) );
+	if( !Voxels )
+		return;
+
+	// Solid spans beside the column, unloaded neighbours hold nothing to hang on to
+	TArray< FVoxelSpan, TInlineAllocator< 16 > > NeighbourSpans;
+	for( const FIntPoint& Direction: CoordinateDirections )
+	{
+		const FIntPoint Neighbour = ColumnCoordinate + Direction;
+		if( const FChunkVoxels* NeighbourVoxels = Query.FindVoxels( FIntVector( Neighbour.X, Neighbour.Y, OriginZ ) ) )
+			NeighbourSpans.Append( NeighbourVoxels->GetColumn( Neighbour ) );
+	}
+
+	Algo::SortBy( NeighbourSpans, []( const FVoxelSpan& Span ) { return Span.Bottom; } );
+
+	const auto AddAirRun = [ & ]( const int32 AirBottom, const int32 AirTop )
+	{
+		// The bottom of the column has nothing loaded below it to stand on
+		if( AirBottom > 0 )
+			Cells->Add( FWalkCell{ .Z = static_cast< uint16 >( AirBottom ), .Flags = EWalkCellFlags::Grounded } );
+
+		// Cells higher up hang on to a wall when a neighbour of the voxel below them is solid
+		int32 Cursor = AirBottom + 1;
+		for( const FVoxelSpan& Span: NeighbourSpans )
+		{
+			const int32 Bottom = FMath::Max< int32 >( Cursor, Span.Bottom + 1 );
+			const int32 Top    = FMath::Min< int32 >( AirTop, Span.Top + 1 );
+			for( int32 Z = Bottom; Z < Top; ++Z )
+				Cells->Add( FWalkCell{ .Z = static_cast< uint16 >( Z ), .Flags = EWalkCellFlags::Ledge } );
+
+			Cursor = FMath::Max( Cursor, Top );
+		}
+	};
+
+	const TConstArrayView< FVoxelSpan > Column = Voxels->GetColumn( ColumnCoordinate );
+
+	int32 AirBottom = 0;
+	for( const FVoxelSpan& Span: Column )
+	{
+		if( AirBottom < Span.Bottom )
+			AddAirRun( AirBottom, Span.Bottom );
+
+		AirBottom = Span.Top;
+	}
+
+	if( AirBottom < Voxels->GetExtent().Z )
+		AddAirRun( AirBottom, Voxels->GetExtent().Z );
+}
+
+void FChunkWalkGraph::UpdateEdges( const FIntPoint& ColumnCoordinate, FWorldVoxelQuery& Query )
+{
+	FColumn* Cells = FindColumn( ColumnCoordinate );
+	if( !Cells )
+		return;
+
+	for( FWalkCell& Cell: *Cells )
+		Cell.Edges = GetEdges( FIntVector( ColumnCoordinate.X, ColumnCoordinate.Y, OriginZ + Cell.Z ), Cell.IsGrounded(), Query );
+}
+
+uint8 FChunkWalkGraph::GetEdges( const FIntVector& VoxelCoordinate, const bool IsGrounded, FWorldVoxelQuery& Query )
+{
+	uint8 Edges = 0;
+	for( int32 Direction = 0; Direction < HexagonDirections.Num(); ++Direction )
+	{
+		const FWalkCell* Neighbour = Query.FindWalkCell( VoxelCoordinate + HexagonDirections[ Direction ] );
+		if( Neighbour && ( Neighbour->IsGrounded() || ( IsGrounded && EnumHasAnyFlags( Neighbour->Flags, EWalkCellFlags::Ledge ) ) ) )
+			Edges |= 1 << Direction;
+	}
+
+	return Edges;
+}
+
+FChunkWalkGraph::FColumn* FChunkWalkGraph::FindColumn( const FIntPoint& ColumnCoordinate )
+{
+	if( !IsInside( ColumnCoordinate ) )
+		return nullptr;
+
+	const FIntPoint Local = ColumnCoordinate - Min;
+	return &Columns[ Local.X * Extent.Y + Local.Y ];
+}
+
+const FChunkWalkGraph::FColumn* FChunkWalkGraph::FindColumn( const FIntPoint& ColumnCoordinate ) const
+{
+	return const_cast< FChunkWalkGraph* >( this )->FindColumn( ColumnCoordinate );
+}
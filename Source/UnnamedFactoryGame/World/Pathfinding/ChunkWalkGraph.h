@@ -0,0 +1,70 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FWorldVoxelQuery;
+struct FChunkVoxels;
+
+enum class EWalkCellFlags : uint8
+{
+	None = 0,
+
+	/** The voxel below is solid */
+	Grounded = 1 << 0,
+
+	/** The voxel below is air but one of its horizontal neighbours is solid, reachable from grounded cells only */
+	Ledge = 1 << 1,
+};
+ENUM_CLASS_FLAGS( EWalkCellFlags )
+
+/**
+ * Air voxel a unit can stand in, bit i of Edges is set when HexagonDirections[ i ] leads to another walkable cell.
+ */
+struct FWalkCell
+{
+	uint16         Z     = 0;
+	EWalkCellFlags Flags = EWalkCellFlags::None;
+	uint8          Edges = 0;
+
+	bool IsGrounded() const { return EnumHasAnyFlags( Flags, EWalkCellFlags::Grounded ); }
+};
+
+/**
+ * Walkable cells of one chunk, kept per column and sorted by height so pathfinding never reads voxels.
+ * Cells depend on the voxels of their own and the neighbouring columns, edges on the cells around them,
+ * so both are recomputed per column and an edit only touches the columns next to it.
+ */
+struct UNNAMEDFACTORYGAME_API FChunkWalkGraph
+{
+	void Init( const FChunkVoxels& Voxels );
+
+	bool IsEmpty() const { return Columns.IsEmpty(); }
+	bool IsInside( const FIntPoint& ColumnCoordinate ) const;
+
+	const FWalkCell* Find( const FIntVector& VoxelCoordinate ) const;
+
+	/** Cells of the column bottom to top, their Z is relative to GetOriginZ */
+	TConstArrayView< FWalkCell > GetCells( const FIntPoint& ColumnCoordinate ) const;
+	int32                        GetOriginZ() const { return OriginZ; }
+
+	/** Recomputes which voxels of the column are walkable, their edges stay empty until UpdateEdges */
+	void UpdateCells( const FIntPoint& ColumnCoordinate, FWorldVoxelQuery& Query );
+	void UpdateEdges( const FIntPoint& ColumnCoordinate, FWorldVoxelQuery& Query );
+
+	/** Edges of the air voxel at VoxelCoordinate, which does not need to be walkable itself */
+	static uint8 GetEdges( const FIntVector& VoxelCoordinate, bool IsGrounded, FWorldVoxelQuery& Query );
+
+private:
+	using FColumn = TArray< FWalkCell, TInlineAllocator< 2 > >;
+
+	FColumn*       FindColumn( const FIntPoint& ColumnCoordinate );
+	const FColumn* FindColumn( const FIntPoint& ColumnCoordinate ) const;
+
+	FIntPoint Min     = FIntPoint::ZeroValue;
+	FIntPoint Extent  = FIntPoint::ZeroValue;
+	int32     OriginZ = 0;
+
+	TArray< FColumn > Columns;
+};
@@ -2,122 +2,41 @@
 
 #include "NavigationComponent.h"
 
+#include "NavigationSubSystem.h"
 #include "UnnamedFactoryGame/World/Generation/WorldGenerationSubSystem.h"
-
-float FVoxelNode::CalculateFutureCost( const FVoxelNode& Other ) const
-{
-	const int32 Q = Coordinate.X - Other.Coordinate.X;
-	const int32 R = Coordinate.Y - Other.Coordinate.Y;
-	const int32 S = ( -Coordinate.X - Coordinate.Y ) - ( -Other.Coordinate.X - Other.Coordinate.Y );
-
-	const float Horizontal = ( FMath::Abs( Q ) + FMath::Abs( R ) + FMath::Abs( S ) ) / 2;
-	const float Vertical   = FMath::Abs( Coordinate.Z - Other.Coordinate.Z );
-	return Horizontal + Vertical;
-}
+#include "UnnamedFactoryGame/World/Generation/WorldVoxelQuery.h"
 
 UNavigationComponent::UNavigationComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 }
 
-bool UNavigationComponent::CalculatePath( const FVector& TargetLocation, TArray< FHexagonVoxel >& OutPath ) const
+bool UNavigationComponent::RequestPath( const FVector& TargetLocation, FPathCallback&& Callback )
 {
-	UWorldGenerationSubSystem* WorldGenerationSubSystem = UWorldGenerationSubSystem::Get( this );
+	FWorldVoxelQuery Query( UWorldGenerationSubSystem::Get( this ) );
 
-	FHexagonVoxel StartVoxel;
-	FHexagonVoxel TargetVoxel;
-	if( !WorldGenerationSubSystem->GetVoxel( GetOwner()->GetActorLocation(), StartVoxel ) )
+	const FVoxelView StartVoxel  = Query.GetView( GetOwner()->GetActorLocation() );
+	const FVoxelView TargetVoxel = Query.GetView( TargetLocation );
+	if( !StartVoxel.IsValid() || !TargetVoxel.IsValid() )
 		return false;
 
-	if( !WorldGenerationSubSystem->GetVoxel( TargetLocation, TargetVoxel ) )
-		return false;
-
-	const FVoxelNode TargetNode{ .Coordinate = TargetVoxel.GridLocation };
-
-	TArray< FVoxelNode >           OpenNodes;
-	TSet< FVoxelNode >             ClosedNodes;
-	TMap< FIntVector, FIntVector > ParentMap;
-	TMap< FIntVector, float >      CurrentCostMap;
+	// Only the latest request of the component may hand its path out
+	const uint32 RequestId = ++LatestRequestId;
 
-	FVoxelNode CurrentNode{ .Coordinate = StartVoxel.GridLocation };
-	OpenNodes.HeapPush( CurrentNode );
-
-	while( !OpenNodes.IsEmpty() )
+	auto OnPathFound = [ WeakThis = TWeakObjectPtr< UNavigationComponent >( this ), RequestId, Callback = MoveTemp( Callback ) ]( const bool IsFound, const TConstArrayView< FIntVector > Path )
 	{
-		OpenNodes.HeapPop( CurrentNode );
-
-		if( ClosedNodes.Contains( CurrentNode ) )
-			continue;
-
-		if( CurrentNode.Coordinate == TargetVoxel.GridLocation )
-		{
-			OutPath = ReconstructPath( ParentMap, CurrentNode.Coordinate );
-			return true;
-		}
-
-		ClosedNodes.Add( CurrentNode );
-
-		for( const FIntVector& Direction: HexagonDirections )
-		{
-			FVoxelNode NeighborNode{ .Coordinate = CurrentNode.Coordinate + Direction };
-
-			if( ClosedNodes.Contains( NeighborNode ) )
-				continue;
+		if( !IsFound || !WeakThis.IsValid() || WeakThis->LatestRequestId != RequestId )
+			return;
 
-			FHexagonVoxel Voxel;
-			if( !WorldGenerationSubSystem->GetVoxel( NeighborNode.Coordinate, Voxel ) || Voxel.Type != EVoxelType::Air )
-				continue;
+		TArray< FHexagonVoxel > Voxels;
+		Voxels.Reserve( Path.Num() );
+		for( const FIntVector& Coordinate: Path )
+			Voxels.Add( FHexagonVoxel( Coordinate ) );
 
-			if( !WorldGenerationSubSystem->GetVoxel( NeighborNode.Coordinate - FIntVector( 0, 0, 1 ), Voxel ) )
-				continue;
+		Callback( MoveTemp( Voxels ) );
+	};
 
-			if( Voxel.Type == EVoxelType::Air )
-			{
-				if( !WorldGenerationSubSystem->GetVoxel( CurrentNode.Coordinate - FIntVector( 0, 0, 1 ), Voxel ) || Voxel.Type == EVoxelType::Air )
-					continue;
-
-				bool IsValid = false;
-				for( int32 i = 0; i < 6; ++i )
-				{
-					const FIntVector& BelowDirection = HexagonDirections[ i ];
-
-					if( !WorldGenerationSubSystem->GetVoxel( NeighborNode.Coordinate - FIntVector( 0, 0, 1 ) + BelowDirection, Voxel ) || Voxel.Type == EVoxelType::Air )
-						continue;
-
-					IsValid = true;
-					break;
-				}
-
-				if( !IsValid )
-					continue;
-			}
-
-			const float CurrentCost = CurrentCostMap.FindRef( CurrentNode.Coordinate ) + 1;
-			if( CurrentCostMap.Contains( NeighborNode.Coordinate ) && CurrentCost > CurrentCostMap.FindRef( NeighborNode.Coordinate ) )
-				continue;
-
-			ParentMap.Add( NeighborNode.Coordinate, CurrentNode.Coordinate );
-			CurrentCostMap.Add( NeighborNode.Coordinate, CurrentCost );
-
-			NeighborNode.Cost = CurrentCost + NeighborNode.CalculateFutureCost( TargetNode );
-			OpenNodes.HeapPush( NeighborNode );
-		}
-	}
-
-	return false;
-}
-
-TArray< FHexagonVoxel > UNavigationComponent::ReconstructPath( const TMap< FIntVector, FIntVector >& ParentMap, FIntVector& CurrentNode ) const
-{
-	TArray< FHexagonVoxel > Path;
-	Path.Add( FHexagonVoxel( CurrentNode ) );
-
-	while( ParentMap.Contains( CurrentNode ) )
-	{
-		CurrentNode = ParentMap[ CurrentNode ];
-		Path.Add( FHexagonVoxel( CurrentNode ) );
-	}
+	UNavigationSubSystem::Get( this )->RequestPath( StartVoxel.Coordinate, TargetVoxel.Coordinate, MoveTemp( OnPathFound ) );
 
-	Algo::Reverse( Path );
-	return Path;
+	return true;
 }
@@ -8,22 +8,6 @@
 
 #include "NavigationComponent.generated.h"
 
-USTRUCT()
-struct FVoxelNode
-{
-	GENERATED_BODY()
-
-	float      Cost       = 0;
-	FIntVector Coordinate = FIntVector::ZeroValue;
-
-	float CalculateFutureCost( const FVoxelNode& Other ) const;
-
-	bool operator<( const FVoxelNode& Other ) const { return Cost < Other.Cost; }
-	bool operator==( const FVoxelNode& Other ) const { return Coordinate == Other.Coordinate; }
-
-	friend int32 GetTypeHash( const FVoxelNode& Node ) { return HashCombine( HashCombine( Node.Coordinate.X, Node.Coordinate.Y ), Node.Coordinate.Z ); }
-};
-
 UCLASS( ClassGroup = ( Custom ), meta = ( BlueprintSpawnableComponent ) )
 class UNNAMEDFACTORYGAME_API UNavigationComponent : public UActorComponent
 {
@@ -32,8 +16,15 @@ class UNNAMEDFACTORYGAME_API UNavigationComponent : public UActorComponent
 public:
 	UNavigationComponent();
 
-	bool CalculatePath( const FVector& TargetLocation, TArray< FHexagonVoxel >& OutPath ) const;
+	using FPathCallback = TUniqueFunction< void( TArray< FHexagonVoxel >&& Path ) >;
+
+	/**
+	 * Asks for a path from the owner to TargetLocation, Callback runs on a later tick once one was found.
+	 * A newer request replaces the pending one, whose callback then never runs.
+	 * @return False when either end is not loaded
+	 */
+	bool RequestPath( const FVector& TargetLocation, FPathCallback&& Callback );
 
 private:
-	TArray< FHexagonVoxel > ReconstructPath( const TMap< FIntVector, FIntVector >& ParentMap, FIntVector& CurrentNode ) const;
+	uint32 LatestRequestId = 0;
 };
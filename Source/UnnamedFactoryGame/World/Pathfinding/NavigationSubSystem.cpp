@@ -0,0 +1,479 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NavigationSubSystem.h"
+
+#include "Algo/Reverse.h"
+#include "ChunkWalkGraph.h"
+#include "PathSearch.h"
+#include "UnnamedFactoryGame/World/Generation/WorldGenerationSubSystem.h"
+#include "UnnamedFactoryGame/World/Generation/WorldVoxelQuery.h"
+#include "WalkGraphSearch.h"
+
+void UNavigationSubSystem::Initialize( FSubsystemCollectionBase& Collection )
+{
+	Super::Initialize( Collection );
+
+	WorldGenerationSubSystem = Collection.InitializeDependency< UWorldGenerationSubSystem >();
+	if( WorldGenerationSubSystem )
+	{
+		WalkGraphChangedHandle = WorldGenerationSubSystem->OnWalkGraphChanged.AddUObject( this, &UNavigationSubSystem::OnWalkGraphChanged );
+		ChunkUnloadedHandle    = WorldGenerationSubSystem->OnChunkUnloaded.AddUObject( this, &UNavigationSubSystem::OnChunkUnloaded );
+	}
+}
+
+void UNavigationSubSystem::Deinitialize()
+{
+	if( WorldGenerationSubSystem )
+	{
+		WorldGenerationSubSystem->OnWalkGraphChanged.Remove( WalkGraphChangedHandle );
+		WorldGenerationSubSystem->OnChunkUnloaded.Remove( ChunkUnloadedHandle );
+	}
+
+	PortalGraphs.Empty();
+	DirtyPortalGraphs.Empty();
+	UnloadedPortalGraphs.Empty();
+	Requests.Empty();
+	RequestOrder.Empty();
+	ActiveRequests.Empty();
+	SearchPool.Empty();
+
+	Super::Deinitialize();
+}
+
+void UNavigationSubSystem::Tick( const float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	const double EndTime = FPlatformTime::Seconds() + PortalBuildBudget / 1000.;
+	for( int32 NumUpdated = 0; !DirtyPortalGraphs.IsEmpty() && ( NumUpdated == 0 || FPlatformTime::Seconds() < EndTime ); ++NumUpdated )
+	{
+		const FIntPoint ChunkCoordinate = *DirtyPortalGraphs.CreateConstIterator();
+		UpdatePortalGraph( ChunkCoordinate );
+	}
+
+	UpdateRequests( FPlatformTime::Seconds() + PathRequestBudget / 1000. );
+}
+
+void UNavigationSubSystem::RequestPath( const FIntVector& Start, const FIntVector& Target, FPathCallback&& Callback )
+{
+	const FPathRequestKey Key( Start, Target );
+	if( FPathRequest* Request = Requests.Find( Key ) )
+	{
+		Request->Callbacks.Add( MoveTemp( Callback ) );
+		++RequestStats.NumCoalesced;
+		return;
+	}
+
+	FPathRequest& Request = Requests.Add( Key );
+	Request.RequestTime   = FPlatformTime::Seconds();
+	Request.Callbacks.Add( MoveTemp( Callback ) );
+
+	RequestOrder.Add( Key );
+	RequestStats.NumQueued = RequestOrder.Num() + ActiveRequests.Num();
+}
+
+void UNavigationSubSystem::UpdateRequests( const double EndTime )
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	RequestStats.NumAnswered = 0;
+
+	FWorldVoxelQuery Query( WorldGenerationSubSystem );
+
+	// The active requests take turns by the slice, so one that cannot be answered soon does not hold back the ones behind it
+	while( FPlatformTime::Seconds() < EndTime )
+	{
+		while( ActiveRequests.Num() < FMath::Max( MaxActiveRequests, 1 ) && !RequestOrder.IsEmpty() )
+		{
+			const FPathRequestKey Key = RequestOrder.PopFrontValue();
+			Requests[ Key ].Search    = SearchPool.IsEmpty() ? MakeUnique< FPathSearch >() : SearchPool.Pop( EAllowShrinking::No );
+			ActiveRequests.Add( Key );
+		}
+
+		if( ActiveRequests.IsEmpty() )
+			break;
+
+		const FPathRequestKey   Key    = ActiveRequests.PopFrontValue();
+		const EPathSearchStatus Status = StepRequest( Key, Requests[ Key ], Query );
+		if( Status == EPathSearchStatus::InProgress )
+			ActiveRequests.Add( Key );
+		else
+			AnswerRequest( Key, Status == EPathSearchStatus::Found );
+	}
+
+	RequestStats.NumQueued = RequestOrder.Num() + ActiveRequests.Num();
+	RequestStats.Time      = FPlatformTime::Seconds() - StartTime;
+}
+
+FPathRequestStats UNavigationSubSystem::GetRequestStats() const
+{
+	FPathRequestStats Stats = RequestStats;
+	if( RecentRequests.IsEmpty() )
+		return Stats;
+
+	TArray< double > Latencies;
+	Latencies.Reserve( RecentRequests.Num() );
+
+	uint64 TotalExpansions = 0;
+	for( const TPair< double, uint64 >& Recent: RecentRequests )
+	{
+		Latencies.Add( Recent.Key );
+		TotalExpansions    += Recent.Value;
+		Stats.MaxExpansions = FMath::Max( Stats.MaxExpansions, Recent.Value );
+	}
+
+	Latencies.Sort();
+	const auto GetPercentile = [ &Latencies ]( const double Fraction ) { return Latencies[ FMath::Min( FMath::FloorToInt32( Fraction * Latencies.Num() ), Latencies.Num() - 1 ) ]; };
+
+	Stats.LatencyP50        = GetPercentile( .5 );
+	Stats.LatencyP95        = GetPercentile( .95 );
+	Stats.LatencyP99        = GetPercentile( .99 );
+	Stats.AverageExpansions = static_cast< double >( TotalExpansions ) / RecentRequests.Num();
+	return Stats;
+}
+
+EPathSearchStatus UNavigationSubSystem::StepRequest( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query )
+{
+	if( !WorldGenerationSubSystem )
+		return EPathSearchStatus::NotFound;
+
+	// Every phase searches on the request's own search, so its pops are all the request expanded
+	const uint64            NumPopped = Request.Search->GetNumPopped();
+	const EPathSearchStatus Status    = StepPhase( Key, Request, Query );
+	Request.Expansions               += Request.Search->GetNumPopped() - NumPopped;
+
+	if( Status == EPathSearchStatus::InProgress && Request.Expansions >= static_cast< uint64 >( MaxExpansions ) )
+		return EPathSearchStatus::NotFound;
+
+	return Status;
+}
+
+void UNavigationSubSystem::AnswerRequest( const FPathRequestKey& Key, const bool IsFound )
+{
+	// Callbacks may request again, so the request leaves the map first
+	FPathRequest Request = MoveTemp( Requests[ Key ] );
+	Requests.Remove( Key );
+
+	SearchPool.Add( MoveTemp( Request.Search ) );
+
+	RecentRequests.Add( MakeTuple( FPlatformTime::Seconds() - Request.RequestTime, Request.Expansions ) );
+	if( RecentRequests.Num() > NumRecentRequests )
+		RecentRequests.PopFront();
+
+	++RequestStats.NumAnswered;
+
+	const TConstArrayView< FIntVector > Path = IsFound ? TConstArrayView< FIntVector >( Request.Path ) : TConstArrayView< FIntVector >();
+	for( FPathCallback& Callback: Request.Callbacks )
+		Callback( IsFound, Path );
+}
+
+void UNavigationSubSystem::OnWalkGraphChanged( const FIntPoint& ChunkCoordinate )
+{
+	DirtyPortalGraphs.Add( ChunkCoordinate );
+
+	// Stale portals cost at most a failed refinement, stale segments would be handed out as they are
+	if( FChunkPortalGraph* PortalGraph = PortalGraphs.Find( ChunkCoordinate ) )
+		PortalGraph->Segments.Reset();
+}
+
+void UNavigationSubSystem::OnChunkUnloaded( const FIntPoint& ChunkCoordinate )
+{
+	// A graph that missed an edit can no longer be rebuilt, it is gone until the chunk loads again
+	if( DirtyPortalGraphs.Remove( ChunkCoordinate ) > 0 )
+	{
+		PortalGraphs.Remove( ChunkCoordinate );
+		return;
+	}
+
+	// Refined segments are only followed while the walk graph is there, the portals keep plans crossing the chunk
+	FChunkPortalGraph* PortalGraph = PortalGraphs.Find( ChunkCoordinate );
+	if( !PortalGraph )
+		return;
+
+	PortalGraph->Segments.Reset();
+	UnloadedPortalGraphs.Add( ChunkCoordinate );
+
+	while( UnloadedPortalGraphs.Num() > MaxUnloadedPortalGraphs )
+	{
+		const FIntPoint Oldest = UnloadedPortalGraphs.PopFrontValue();
+		if( !FindWalkGraph( Oldest ) )
+			PortalGraphs.Remove( Oldest );
+	}
+}
+
+bool UNavigationSubSystem::UpdatePortalGraph( const FIntPoint& ChunkCoordinate )
+{
+	if( DirtyPortalGraphs.Remove( ChunkCoordinate ) == 0 )
+		return PortalGraphs.Contains( ChunkCoordinate );
+
+	const FChunkWalkGraph* WalkGraph = FindWalkGraph( ChunkCoordinate );
+	if( !WalkGraph )
+	{
+		PortalGraphs.Remove( ChunkCoordinate );
+		return false;
+	}
+
+	FWorldVoxelQuery Query( WorldGenerationSubSystem );
+	PortalGraphs.FindOrAdd( ChunkCoordinate ).Build( ChunkCoordinate, *WalkGraph, Query, FPathSearch::Get(), MaxPortalWidth );
+	return true;
+}
+
+EPathSearchStatus UNavigationSubSystem::StepPhase( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query )
+{
+	const FIntVector& Start  = Key.Key;
+	const FIntVector& Target = Key.Value;
+
+	FPathSearch& Search = *Request.Search;
+
+	const FIntPoint StartChunk  = FChunk::VoxelToChunk( Start );
+	const FIntPoint TargetChunk = FChunk::VoxelToChunk( Target );
+
+	const auto IsInStartChunk  = [ &StartChunk ]( const FIntVector& Coordinate ) { return FChunk::VoxelToChunk( Coordinate ) == StartChunk; };
+	const auto IsInTargetChunk = [ &TargetChunk ]( const FIntVector& Coordinate ) { return FChunk::VoxelToChunk( Coordinate ) == TargetChunk; };
+
+	switch( Request.Phase )
+	{
+		case EPathRequestPhase::Queued:
+		{
+			if( FWalkGraphSearch::GetFutureCost( Start, Target ) <= HierarchicalDistance )
+			{
+				FWalkGraphSearch::BeginPath( Search, Start, Target );
+				Request.Phase = EPathRequestPhase::Searching;
+				return EPathSearchStatus::InProgress;
+			}
+
+			// A portal graph is rebuilt per slice, so both ends cost at most two slices to bring up to date
+			if( DirtyPortalGraphs.Contains( StartChunk ) || DirtyPortalGraphs.Contains( TargetChunk ) )
+			{
+				UpdatePortalGraph( DirtyPortalGraphs.Contains( StartChunk ) ? StartChunk : TargetChunk );
+				return EPathSearchStatus::InProgress;
+			}
+
+			if( !PortalGraphs.Contains( StartChunk ) || !PortalGraphs.Contains( TargetChunk ) )
+				return EPathSearchStatus::NotFound;
+
+			FWalkGraphSearch::BeginFlood( Search, Start );
+			Request.Phase = EPathRequestPhase::FloodingStart;
+			return EPathSearchStatus::InProgress;
+		}
+		case EPathRequestPhase::FloodingStart:
+		{
+			// Start reaches the portals of its chunk and the target when they share it
+			if( FWalkGraphSearch::StepFlood( Search, Query, false, IsInStartChunk, ExpansionsPerSlice ) == EPathSearchStatus::InProgress )
+				return EPathSearchStatus::InProgress;
+
+			const FChunkPortalGraph* StartGraph = PortalGraphs.Find( StartChunk );
+			if( !StartGraph )
+				return EPathSearchStatus::NotFound;
+
+			Request.StartPortals.Reset( StartGraph->Portals.Num() );
+			for( const FChunkPortal& Portal: StartGraph->Portals )
+				Request.StartPortals.Emplace( Portal.Coordinate, Search.Costs[ Search.FindOrAdd( Portal.Coordinate ) ] );
+
+			Request.DirectCost = StartChunk == TargetChunk ? Search.Costs[ Search.FindOrAdd( Target ) ] : MAX_flt;
+
+			FWalkGraphSearch::BeginFlood( Search, Target );
+			Request.Phase = EPathRequestPhase::FloodingTarget;
+			return EPathSearchStatus::InProgress;
+		}
+		case EPathRequestPhase::FloodingTarget:
+		{
+			// The portals of the target chunk reach the target
+			if( FWalkGraphSearch::StepFlood( Search, Query, true, IsInTargetChunk, ExpansionsPerSlice ) == EPathSearchStatus::InProgress )
+				return EPathSearchStatus::InProgress;
+
+			const FChunkPortalGraph* TargetGraph = PortalGraphs.Find( TargetChunk );
+			if( !TargetGraph )
+				return EPathSearchStatus::NotFound;
+
+			// Kept by coordinate, the portal graph may be rebuilt with other indices while the plan is searched
+			Request.TargetCosts.Reset();
+			for( const FChunkPortal& Portal: TargetGraph->Portals )
+				Request.TargetCosts.Add( Portal.Coordinate, Search.Costs[ Search.FindOrAdd( Portal.Coordinate ) ] );
+
+			Search.Begin( Start );
+
+			const int32 StartNode     = Search.FindOrAdd( Start );
+			Search.Costs[ StartNode ] = 0;
+			Search.Push( StartNode, FWalkGraphSearch::GetFutureCost( Start, Target ) );
+
+			Request.Phase = EPathRequestPhase::Planning;
+			return EPathSearchStatus::InProgress;
+		}
+		case EPathRequestPhase::Planning:
+			return StepPlanning( Key, Request );
+		case EPathRequestPhase::Refining:
+			return StepRefining( Key, Request, Query );
+		case EPathRequestPhase::Searching:
+			return FWalkGraphSearch::StepPath( Search, Query, Target, []( const FIntVector& ) { return true; }, ExpansionsPerSlice, Request.Path );
+	}
+
+	return EPathSearchStatus::NotFound;
+}
+
+EPathSearchStatus UNavigationSubSystem::StepPlanning( const FPathRequestKey& Key, FPathRequest& Request )
+{
+	const FIntVector& Start  = Key.Key;
+	const FIntVector& Target = Key.Value;
+
+	const FIntPoint TargetChunk = FChunk::VoxelToChunk( Target );
+
+	FPathSearch& Search = *Request.Search;
+	for( int32 Expansions = 0; Expansions < ExpansionsPerSlice; ++Expansions )
+	{
+		if( Search.IsEmpty() )
+			return EPathSearchStatus::NotFound;
+
+		const int32      CurrentNode       = Search.Pop();
+		const FIntVector CurrentCoordinate = Search.Coordinates[ CurrentNode ];
+		const float      CurrentCost       = Search.Costs[ CurrentNode ];
+
+		if( CurrentCoordinate == Target )
+		{
+			Request.Waypoints.Reset();
+			for( int32 Node = CurrentNode; Node != INDEX_NONE; Node = Search.Parents[ Node ] )
+				Request.Waypoints.Add( Search.Coordinates[ Node ] );
+
+			Algo::Reverse( Request.Waypoints );
+
+			Request.Path         = { Start };
+			Request.NextWaypoint = 1;
+			Request.Phase        = EPathRequestPhase::Refining;
+			return EPathSearchStatus::InProgress;
+		}
+
+		const auto Relax = [ & ]( const FIntVector& NeighborCoordinate, const float StepCost )
+		{
+			if( StepCost == MAX_flt )
+				return;
+
+			const float Cost         = CurrentCost + StepCost;
+			const int32 NeighborNode = Search.FindOrAdd( NeighborCoordinate );
+			if( Search.IsClosed( NeighborNode ) || Cost >= Search.Costs[ NeighborNode ] )
+				return;
+
+			Search.Costs[ NeighborNode ]   = Cost;
+			Search.Parents[ NeighborNode ] = CurrentNode;
+			Search.Push( NeighborNode, Cost + FWalkGraphSearch::GetFutureCost( NeighborCoordinate, Target ) );
+		};
+
+		if( CurrentCoordinate == Start )
+		{
+			for( const TPair< FIntVector, float >& StartPortal: Request.StartPortals )
+				Relax( StartPortal.Key, StartPortal.Value );
+
+			Relax( Target, Request.DirectCost );
+		}
+
+		// The start can stand on a portal too
+		const FIntPoint          CurrentChunk = FChunk::VoxelToChunk( CurrentCoordinate );
+		const FChunkPortalGraph* PortalGraph  = PortalGraphs.Find( CurrentChunk );
+		const int32              PortalIndex  = PortalGraph ? PortalGraph->FindPortal( CurrentCoordinate ) : INDEX_NONE;
+		if( PortalIndex == INDEX_NONE || PortalGraph->Portals[ PortalIndex ].Coordinate != CurrentCoordinate )
+			continue;
+
+		const FChunkPortal& Portal = PortalGraph->Portals[ PortalIndex ];
+		for( int32 i = 0; i < PortalGraph->Portals.Num(); ++i )
+			Relax( PortalGraph->Portals[ i ].Coordinate, Portal.Costs[ i ] );
+
+		if( const float* TargetCost = CurrentChunk == TargetChunk ? Request.TargetCosts.Find( CurrentCoordinate ) : nullptr )
+			Relax( Target, *TargetCost );
+
+		for( const TPair< FIntVector, float >& Exit: Portal.Exits )
+		{
+			// Portal graphs built at different times can disagree about their shared border until both are rebuilt
+			const FChunkPortalGraph* NeighbourGraph = PortalGraphs.Find( FChunk::VoxelToChunk( Exit.Key ) );
+			const int32              NeighbourIndex = NeighbourGraph ? NeighbourGraph->FindPortal( Exit.Key ) : INDEX_NONE;
+			if( NeighbourIndex == INDEX_NONE )
+				continue;
+
+			const FIntVector& NeighbourPortal = NeighbourGraph->Portals[ NeighbourIndex ].Coordinate;
+			Relax( NeighbourPortal, Exit.Value + FWalkGraphSearch::GetFutureCost( Exit.Key, NeighbourPortal ) );
+		}
+	}
+
+	return Search.IsEmpty() ? EPathSearchStatus::NotFound : EPathSearchStatus::InProgress;
+}
+
+EPathSearchStatus UNavigationSubSystem::StepRefining( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query )
+{
+	const FIntVector& From = Request.Waypoints[ Request.NextWaypoint - 1 ];
+	const FIntVector& To   = Request.Waypoints[ Request.NextWaypoint ];
+
+	const FIntPoint FromChunk = FChunk::VoxelToChunk( From );
+	const FIntPoint ToChunk   = FChunk::VoxelToChunk( To );
+
+	FPathSearch& Search = *Request.Search;
+
+	if( !Request.IsRefiningHop )
+	{
+		if( !FindWalkGraph( FromChunk ) || !FindWalkGraph( ToChunk ) )
+			Request.Path.Add( To );
+		else if( const TArray< FIntVector >* Cached = FindSegment( From, To, false ) )
+			Request.Path.Append( TConstArrayView< FIntVector >( *Cached ).RightChop( 1 ) );
+		else
+		{
+			FWalkGraphSearch::BeginPath( Search, From, To );
+			Request.IsRefiningHop = true;
+			return EPathSearchStatus::InProgress;
+		}
+
+		return ++Request.NextWaypoint == Request.Waypoints.Num() ? EPathSearchStatus::Found : EPathSearchStatus::InProgress;
+	}
+
+	const auto IsInside = [ &FromChunk, &ToChunk ]( const FIntVector& Coordinate )
+	{
+		const FIntPoint Chunk = FChunk::VoxelToChunk( Coordinate );
+		return Chunk == FromChunk || Chunk == ToChunk;
+	};
+
+	TArray< FIntVector >    Segment;
+	const EPathSearchStatus Status = FWalkGraphSearch::StepPath( Search, Query, To, IsInside, ExpansionsPerSlice, Segment );
+	if( Status == EPathSearchStatus::InProgress )
+		return EPathSearchStatus::InProgress;
+
+	Request.IsRefiningHop = false;
+
+	// The plan crossed a gap its portals did not show, rebuilding them may not close it, so the rest is searched directly instead
+	if( Status == EPathSearchStatus::NotFound )
+	{
+		OnWalkGraphChanged( FromChunk );
+		OnWalkGraphChanged( ToChunk );
+
+		Request.Path.Reset();
+		FWalkGraphSearch::BeginPath( Search, Key.Key, Key.Value );
+		Request.Phase = EPathRequestPhase::Searching;
+		return EPathSearchStatus::InProgress;
+	}
+
+	Request.Path.Append( TConstArrayView< FIntVector >( Segment ).RightChop( 1 ) );
+
+	if( TArray< FIntVector >* Slot = FindSegment( From, To, true ) )
+		*Slot = MoveTemp( Segment );
+
+	return ++Request.NextWaypoint == Request.Waypoints.Num() ? EPathSearchStatus::Found : EPathSearchStatus::InProgress;
+}
+
+TArray< FIntVector >* UNavigationSubSystem::FindSegment( const FIntVector& From, const FIntVector& To, const bool Add )
+{
+	// Only crossings between two portals of one chunk are worth keeping, the ends of a path are rarely asked for again
+	const FIntPoint    Chunk       = FChunk::VoxelToChunk( From );
+	FChunkPortalGraph* PortalGraph = Chunk == FChunk::VoxelToChunk( To ) ? PortalGraphs.Find( Chunk ) : nullptr;
+	const int32        FromPortal  = PortalGraph ? PortalGraph->FindPortal( From ) : INDEX_NONE;
+	const int32        ToPortal    = PortalGraph ? PortalGraph->FindPortal( To ) : INDEX_NONE;
+
+	if( FromPortal == INDEX_NONE || ToPortal == INDEX_NONE )
+		return nullptr;
+
+	if( PortalGraph->Portals[ FromPortal ].Coordinate != From || PortalGraph->Portals[ ToPortal ].Coordinate != To )
+		return nullptr;
+
+	const FIntPoint SegmentKey( FromPortal, ToPortal );
+	return Add ? &PortalGraph->Segments.FindOrAdd( SegmentKey ) : PortalGraph->Segments.Find( SegmentKey );
+}
+
+const FChunkWalkGraph* UNavigationSubSystem::FindWalkGraph( const FIntPoint& ChunkCoordinate ) const
+{
+	const FChunk* Chunk = WorldGenerationSubSystem->GetChunk( ChunkCoordinate );
+	return Chunk && !Chunk->WalkGraph.IsEmpty() ? &Chunk->WalkGraph : nullptr;
+}
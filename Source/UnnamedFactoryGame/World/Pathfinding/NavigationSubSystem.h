@@ -0,0 +1,211 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ChunkPortalGraph.h"
+#include "Containers/RingBuffer.h"
+#include "CoreMinimal.h"
+#include "PathSearch.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WalkGraphSearch.h"
+
+#include "NavigationSubSystem.generated.h"
+
+class UWorldGenerationSubSystem;
+
+struct FPathRequestStats
+{
+	/** Requests waiting or in progress, duplicates count once */
+	int32 NumQueued = 0;
+
+	/** Requests that joined an identical one instead of being searched again */
+	int32 NumCoalesced = 0;
+
+	/** Seconds from submission to answer over the last answered requests, computed when the stats are read */
+	double LatencyP50 = 0;
+	double LatencyP95 = 0;
+	double LatencyP99 = 0;
+
+	/** Nodes expanded per request over the last answered requests */
+	double AverageExpansions = 0;
+	uint64 MaxExpansions     = 0;
+
+	/** Work done during the last tick */
+	int32  NumAnswered = 0;
+	double Time        = 0;
+};
+
+/**
+ * Finds paths over the walk graphs, long ones are planned between chunk portals first and only then refined voxel by voxel.
+ * Requests advance in turns on the game thread within a frame budget, a search that does not fit continues next frame.
+ */
+UCLASS( Config = Game )
+class UNNAMEDFACTORYGAME_API UNavigationSubSystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UNavigationSubSystem* Get( const UObject* WorldContextObject ) { return WorldContextObject->GetWorld()->GetSubsystem< UNavigationSubSystem >(); }
+
+	virtual void Initialize( FSubsystemCollectionBase& Collection ) override;
+	virtual void Deinitialize() override;
+
+	virtual TStatId GetStatId() const override { return TStatId(); }
+
+	virtual void Tick( float DeltaTime ) override;
+
+	/** IsFound is false when no path exists, Path holds both ends and stretches through unloaded chunks only hold the portals they pass */
+	using FPathCallback = TUniqueFunction< void( bool IsFound, TConstArrayView< FIntVector > Path ) >;
+
+	/**
+	 * Queues a path search that runs during the following ticks within PathRequestBudget, Callback runs on the game thread once it is answered.
+	 * A request for the same ends as one that is still queued waits for that one instead.
+	 */
+	void RequestPath( const FIntVector& Start, const FIntVector& Target, FPathCallback&& Callback );
+
+	FPathRequestStats GetRequestStats() const;
+
+private:
+	/** Every phase but Queued advances by at most ExpansionsPerSlice nodes at a time */
+	enum class EPathRequestPhase : uint8
+	{
+		Queued,
+
+		/** Direct search on the walk graphs, for short requests and for long ones whose plan could not be refined */
+		Searching,
+
+		/** Costs from the start to the portals of its chunk */
+		FloodingStart,
+
+		/** Costs from the portals of the target chunk to the target */
+		FloodingTarget,
+
+		/** Search over the portal graphs */
+		Planning,
+
+		/** Search of one hop between two waypoints after the other */
+		Refining,
+	};
+
+	struct FPathRequest
+	{
+		TArray< FPathCallback, TInlineAllocator< 1 > > Callbacks;
+
+		EPathRequestPhase Phase       = EPathRequestPhase::Queued;
+		double            RequestTime = 0;
+		uint64            Expansions  = 0;
+
+		/** Portals of the start chunk with the cost of walking to them, and to the target when it shares the chunk */
+		TArray< TPair< FIntVector, float > > StartPortals;
+		float                                DirectCost = MAX_flt;
+
+		/** Cost of walking to the target from the portals of its chunk */
+		TMap< FIntVector, float > TargetCosts;
+
+		/** Portal plan of a long request, NextWaypoint indexes the one refined towards next */
+		TArray< FIntVector > Waypoints;
+		int32                NextWaypoint = 0;
+
+		/** The hop towards Waypoints[ NextWaypoint ] is being searched on Search */
+		bool IsRefiningHop = false;
+
+		TArray< FIntVector > Path;
+
+		/** Taken from SearchPool while the request is active, every phase searches on it across ticks */
+		TUniquePtr< FPathSearch > Search;
+	};
+
+	using FPathRequestKey = TPair< FIntVector, FIntVector >;
+
+	void UpdateRequests( double EndTime );
+
+	/** Advances the request by one slice, NotFound once it expanded MaxExpansions nodes */
+	EPathSearchStatus StepRequest( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query );
+
+	/** One slice of the request's current phase */
+	EPathSearchStatus StepPhase( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query );
+
+	/** Expands up to ExpansionsPerSlice nodes of the search over the portal graphs, the plan becomes the request's waypoints once found */
+	EPathSearchStatus StepPlanning( const FPathRequestKey& Key, FPathRequest& Request );
+
+	/** Refines the next hop of the plan by up to ExpansionsPerSlice nodes, a hop that cannot be walked hands the request to a direct search */
+	EPathSearchStatus StepRefining( const FPathRequestKey& Key, FPathRequest& Request, FWorldVoxelQuery& Query );
+
+	void AnswerRequest( const FPathRequestKey& Key, bool IsFound );
+
+	void OnWalkGraphChanged( const FIntPoint& ChunkCoordinate );
+	void OnChunkUnloaded( const FIntPoint& ChunkCoordinate );
+
+	/** Rebuilds the portal graph when it is dirty, false when the chunk is not loaded and there is none to use */
+	bool UpdatePortalGraph( const FIntPoint& ChunkCoordinate );
+
+	/** Cache slot of the refined path between two portals of one chunk, null when From and To are not such a pair */
+	TArray< FIntVector >* FindSegment( const FIntVector& From, const FIntVector& To, bool Add );
+
+	const FChunkWalkGraph* FindWalkGraph( const FIntPoint& ChunkCoordinate ) const;
+
+	UPROPERTY( Transient )
+	TObjectPtr< UWorldGenerationSubSystem > WorldGenerationSubSystem;
+
+	FDelegateHandle WalkGraphChangedHandle;
+	FDelegateHandle ChunkUnloadedHandle;
+
+	/** Kept without their cached segments when their chunk unloads so plans still cross it, unless the chunk changed since they were built */
+	TMap< FIntPoint, FChunkPortalGraph > PortalGraphs;
+
+	/** Chunks whose walk graph changed since their portal graph was built */
+	TSet< FIntPoint > DirtyPortalGraphs;
+
+	/** Chunks whose portal graph outlived them, oldest first, the ones that loaded again are skipped when evicting */
+	TRingBuffer< FIntPoint > UnloadedPortalGraphs;
+
+	TMap< FPathRequestKey, FPathRequest > Requests;
+
+	/** Keys of the waiting Requests in the order they were made */
+	TRingBuffer< FPathRequestKey > RequestOrder;
+
+	/** Keys of the Requests in progress, they take turns by the slice in this order */
+	TRingBuffer< FPathRequestKey > ActiveRequests;
+
+	/** Searches of answered requests kept for the next ones, so their buffers stay grown and no request shares FPathSearch::Get() with the work in between */
+	TArray< TUniquePtr< FPathSearch > > SearchPool;
+
+	/** Latency and expansions of the last answered requests, oldest first */
+	TRingBuffer< TPair< double, uint64 > > RecentRequests;
+
+	static constexpr int32 NumRecentRequests = 256;
+
+	FPathRequestStats RequestStats;
+
+	/** Voxel distance up to which paths are searched directly on the walk graphs */
+	UPROPERTY( Config )
+	int32 HierarchicalDistance = 48;
+
+	/** Portal graphs of unloaded chunks kept at most, the oldest are dropped first */
+	UPROPERTY( Config )
+	int32 MaxUnloadedPortalGraphs = 4096;
+
+	/** Border cells one portal stands for at most */
+	UPROPERTY( Config )
+	int32 MaxPortalWidth = 4;
+
+	/** Milliseconds per frame spent rebuilding dirty portal graphs, at least one is rebuilt when any is dirty */
+	UPROPERTY( Config )
+	float PortalBuildBudget = 1;
+
+	/** Milliseconds per frame spent answering path requests */
+	UPROPERTY( Config )
+	float PathRequestBudget = 2;
+
+	/** Requests in progress at once, one that cannot be answered soon only holds back its share of PathRequestBudget */
+	UPROPERTY( Config )
+	int32 MaxActiveRequests = 8;
+
+	/** Nodes a search expands between two checks of the frame budget */
+	UPROPERTY( Config )
+	int32 ExpansionsPerSlice = 256;
+
+	/** Nodes after which a search gives up, an unreachable target would otherwise make it explore everything that is loaded */
+	UPROPERTY( Config )
+	int32 MaxExpansions = 200000;
+};
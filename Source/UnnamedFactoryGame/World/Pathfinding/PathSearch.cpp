@@ -0,0 +1,150 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PathSearch.h"
+
+void FPathSearch::Begin( const FIntVector& InOrigin )
+{
+	Origin = InOrigin;
+
+	Coordinates.Reset();
+	Costs.Reset();
+	Parents.Reset();
+	HeapIndices.Reset();
+	Heap.Reset();
+
+	if( Slots.IsEmpty() )
+		Rehash( 1024 );
+
+	if( ++Stamp == 0 )
+	{
+		FMemory::Memzero( SlotStamps.GetData(), SlotStamps.Num() * sizeof( uint32 ) );
+		Stamp = 1;
+	}
+}
+
+int32 FPathSearch::FindOrAdd( const FIntVector& Coordinate )
+{
+	if( ( Coordinates.Num() + 1 ) * 2 > Slots.Num() )
+		Rehash( Slots.Num() * 2 );
+
+	const uint32 Mask = Slots.Num() - 1;
+	for( uint32 Slot = Hash( Coordinate ) & Mask;; Slot = ( Slot + 1 ) & Mask )
+	{
+		if( SlotStamps[ Slot ] != Stamp )
+		{
+			SlotStamps[ Slot ] = Stamp;
+			Slots[ Slot ]      = Coordinates.Add( Coordinate );
+			Costs.Add( MAX_flt );
+			Parents.Add( INDEX_NONE );
+			HeapIndices.Add( INDEX_NONE );
+			return Slots[ Slot ];
+		}
+
+		if( Coordinates[ Slots[ Slot ] ] == Coordinate )
+			return Slots[ Slot ];
+	}
+}
+
+void FPathSearch::Push( const int32 Node, const float Priority )
+{
+	int32 Index = HeapIndices[ Node ];
+	checkSlow( Index != ClosedIndex );
+
+	if( Index == INDEX_NONE )
+	{
+		Index = Heap.Add( FHeapEntry{ .Priority = Priority, .Node = Node } );
+		HeapIndices[ Node ] = Index;
+	}
+	else if( Priority < Heap[ Index ].Priority )
+		Heap[ Index ].Priority = Priority;
+	else
+		return;
+
+	SiftUp( Index );
+}
+
+int32 FPathSearch::Pop()
+{
+	const int32 Node = Heap[ 0 ].Node;
+	HeapIndices[ Node ] = ClosedIndex;
+	++NumPopped;
+
+	const FHeapEntry Last = Heap.Pop( EAllowShrinking::No );
+	if( !Heap.IsEmpty() )
+	{
+		Place( 0, Last );
+		SiftDown( 0 );
+	}
+
+	return Node;
+}
+
+uint32 FPathSearch::Hash( const FIntVector& Coordinate ) const
+{
+	const FIntVector Local = Coordinate - Origin;
+	return ( static_cast< uint32 >( Local.X ) * 73856093u ) ^ ( static_cast< uint32 >( Local.Y ) * 19349663u ) ^ ( static_cast< uint32 >( Local.Z ) * 83492791u );
+}
+
+void FPathSearch::Rehash( const int32 NumSlots )
+{
+	Slots.SetNumUninitialized( NumSlots );
+	SlotStamps.SetNumUninitialized( NumSlots );
+	FMemory::Memzero( SlotStamps.GetData(), SlotStamps.Num() * sizeof( uint32 ) );
+
+	Stamp = FMath::Max( Stamp, 1u );
+
+	const uint32 Mask = NumSlots - 1;
+	for( int32 Node = 0; Node < Coordinates.Num(); ++Node )
+	{
+		uint32 Slot = Hash( Coordinates[ Node ] ) & Mask;
+		while( SlotStamps[ Slot ] == Stamp )
+			Slot = ( Slot + 1 ) & Mask;
+
+		SlotStamps[ Slot ] = Stamp;
+		Slots[ Slot ]      = Node;
+	}
+}
+
+void FPathSearch::SiftUp( int32 Index )
+{
+	const FHeapEntry Entry = Heap[ Index ];
+	while( Index > 0 )
+	{
+		const int32 Parent = ( Index - 1 ) / 2;
+		if( Heap[ Parent ].Priority <= Entry.Priority )
+			break;
+
+		Place( Index, Heap[ Parent ] );
+		Index = Parent;
+	}
+
+	Place( Index, Entry );
+}
+
+void FPathSearch::SiftDown( int32 Index )
+{
+	const FHeapEntry Entry = Heap[ Index ];
+	while( true )
+	{
+		int32 Child = Index * 2 + 1;
+		if( Child >= Heap.Num() )
+			break;
+
+		if( Child + 1 < Heap.Num() && Heap[ Child + 1 ].Priority < Heap[ Child ].Priority )
+			++Child;
+
+		if( Entry.Priority <= Heap[ Child ].Priority )
+			break;
+
+		Place( Index, Heap[ Child ] );
+		Index = Child;
+	}
+
+	Place( Index, Entry );
+}
+
+void FPathSearch::Place( const int32 Index, const FHeapEntry& Entry )
+{
+	Heap[ Index ]             = Entry;
+	HeapIndices[ Entry.Node ] = Index;
+}
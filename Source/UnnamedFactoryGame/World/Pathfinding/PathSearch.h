@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSingleton.h"
+
+/**
+ * A* state reused by every search on a thread, so a query allocates nothing once the buffers have grown.
+ * Nodes live in flat arrays indexed by the order they were reached and a coordinate hash table maps into them.
+ * Table slots are stamped with the search that wrote them, starting a search bumps the stamp instead of clearing anything.
+ * Searches that run while another one is in progress use their own instance instead of Get().
+ */
+struct UNNAMEDFACTORYGAME_API FPathSearch : TThreadSingleton< FPathSearch >
+{
+	/** Forgets every node, Origin is subtracted before hashing so coordinates near the start spread evenly */
+	void Begin( const FIntVector& InOrigin );
+
+	/** Node of Coordinate, added unreached with an infinite cost when it is new */
+	int32 FindOrAdd( const FIntVector& Coordinate );
+
+	/** Queues Node or lowers its priority when it already is queued */
+	void Push( int32 Node, float Priority );
+
+	/** Removes the node with the lowest priority from the queue and closes it */
+	int32 Pop();
+
+	bool IsEmpty() const { return Heap.IsEmpty(); }
+	bool IsClosed( const int32 Node ) const { return HeapIndices[ Node ] == ClosedIndex; }
+
+	/** Nodes popped by every search so far, the difference around a query gives its expansions */
+	uint64 GetNumPopped() const { return NumPopped; }
+
+	TArray< FIntVector > Coordinates;
+	TArray< float >      Costs;
+	TArray< int32 >      Parents;
+
+private:
+	static constexpr int32 ClosedIndex = -2;
+
+	struct FHeapEntry
+	{
+		float Priority;
+		int32 Node;
+	};
+
+	uint32 Hash( const FIntVector& Coordinate ) const;
+
+	/** NumSlots has to be a power of two */
+	void Rehash( int32 NumSlots );
+
+	void SiftUp( int32 Index );
+	void SiftDown( int32 Index );
+	void Place( int32 Index, const FHeapEntry& Entry );
+
+	FIntVector Origin = FIntVector::ZeroValue;
+
+	/** Position of every node in Heap, INDEX_NONE when it was never queued and ClosedIndex once popped */
+	TArray< int32 > HeapIndices;
+
+	TArray< FHeapEntry > Heap;
+
+	TArray< int32 >  Slots;
+	TArray< uint32 > SlotStamps;
+	uint32           Stamp = 0;
+
+	uint64 NumPopped = 0;
+};
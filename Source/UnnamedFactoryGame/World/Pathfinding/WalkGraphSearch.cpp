@@ -0,0 +1,152 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WalkGraphSearch.h"
+
+#include "Algo/Reverse.h"
+#include "ChunkWalkGraph.h"
+#include "PathSearch.h"
+#include "UnnamedFactoryGame/World/Generation/HexagonVoxel.h"
+#include "UnnamedFactoryGame/World/Generation/WorldVoxelQuery.h"
+
+float FWalkGraphSearch::GetFutureCost( const FIntVector& From, const FIntVector& To )
+{
+	const int32 Q = From.X - To.X;
+	const int32 R = From.Y - To.Y;
+	const int32 S = ( -From.X - From.Y ) - ( -To.X - To.Y );
+
+	const float Horizontal = ( FMath::Abs( Q ) + FMath::Abs( R ) + FMath::Abs( S ) ) / 2;
+	const float Vertical   = FMath::Abs( From.Z - To.Z );
+	return Horizontal + Vertical;
+}
+
+uint8 FWalkGraphSearch::GetEdges( FWorldVoxelQuery& Query, const FIntVector& VoxelCoordinate )
+{
+	if( const FWalkCell* Cell = Query.FindWalkCell( VoxelCoordinate ) )
+		return Cell->Edges;
+
+	EVoxelType BelowType;
+	const bool IsGrounded = Query.GetType( VoxelCoordinate - FIntVector( 0, 0, 1 ), BelowType ) && BelowType != EVoxelType::Air;
+	return FChunkWalkGraph::GetEdges( VoxelCoordinate, IsGrounded, Query );
+}
+
+bool FWalkGraphSearch::FindPath( FPathSearch&         Search,
+                                 FWorldVoxelQuery&    Query,
+                                 const FIntVector&    Start,
+                                 const FIntVector&    Target,
+                                 const FFilter        Filter,
+                                 TArray< FIntVector >& OutPath )
+{
+	BeginPath( Search, Start, Target );
+	return StepPath( Search, Query, Target, Filter, MAX_int32, OutPath ) == EPathSearchStatus::Found;
+}
+
+void FWalkGraphSearch::BeginPath( FPathSearch& Search, const FIntVector& Start, const FIntVector& Target )
+{
+	Search.Begin( Start );
+
+	const int32 StartNode     = Search.FindOrAdd( Start );
+	Search.Costs[ StartNode ] = 0;
+	Search.Push( StartNode, GetFutureCost( Start, Target ) );
+}
+
+EPathSearchStatus FWalkGraphSearch::StepPath( FPathSearch&          Search,
+                                              FWorldVoxelQuery&     Query,
+                                              const FIntVector&     Target,
+                                              const FFilter         Filter,
+                                              const int32           MaxExpansions,
+                                              TArray< FIntVector >& OutPath )
+{
+	for( int32 Expansions = 0; Expansions < MaxExpansions; ++Expansions )
+	{
+		if( Search.IsEmpty() )
+			return EPathSearchStatus::NotFound;
+
+		const int32      CurrentNode       = Search.Pop();
+		const FIntVector CurrentCoordinate = Search.Coordinates[ CurrentNode ];
+
+		if( CurrentCoordinate == Target )
+		{
+			OutPath.Reset();
+			for( int32 Node = CurrentNode; Node != INDEX_NONE; Node = Search.Parents[ Node ] )
+				OutPath.Add( Search.Coordinates[ Node ] );
+
+			Algo::Reverse( OutPath );
+			return EPathSearchStatus::Found;
+		}
+
+		const float Cost = Search.Costs[ CurrentNode ] + 1;
+		for( uint8 Edges = GetEdges( Query, CurrentCoordinate ); Edges != 0; Edges &= Edges - 1 )
+		{
+			const FIntVector NeighborCoordinate = CurrentCoordinate + HexagonDirections[ FMath::CountTrailingZeros( Edges ) ];
+			if( !Filter( NeighborCoordinate ) )
+				continue;
+
+			const int32 NeighborNode = Search.FindOrAdd( NeighborCoordinate );
+			if( Search.IsClosed( NeighborNode ) || Cost >= Search.Costs[ NeighborNode ] )
+				continue;
+
+			// Edges into a chunk that unloaded since they were built lead nowhere
+			if( !Query.FindWalkCell( NeighborCoordinate ) )
+				continue;
+
+			Search.Costs[ NeighborNode ]   = Cost;
+			Search.Parents[ NeighborNode ] = CurrentNode;
+			Search.Push( NeighborNode, Cost + GetFutureCost( NeighborCoordinate, Target ) );
+		}
+	}
+
+	return Search.IsEmpty() ? EPathSearchStatus::NotFound : EPathSearchStatus::InProgress;
+}
+
+void FWalkGraphSearch::Flood( FPathSearch& Search, FWorldVoxelQuery& Query, const FIntVector& Start, const bool Reverse, const FFilter Filter )
+{
+	BeginFlood( Search, Start );
+	StepFlood( Search, Query, Reverse, Filter, MAX_int32 );
+}
+
+void FWalkGraphSearch::BeginFlood( FPathSearch& Search, const FIntVector& Start )
+{
+	Search.Begin( Start );
+
+	const int32 StartNode     = Search.FindOrAdd( Start );
+	Search.Costs[ StartNode ] = 0;
+	Search.Push( StartNode, 0 );
+}
+
+EPathSearchStatus FWalkGraphSearch::StepFlood( FPathSearch& Search, FWorldVoxelQuery& Query, const bool Reverse, const FFilter Filter, const int32 MaxExpansions )
+{
+	for( int32 Expansions = 0; Expansions < MaxExpansions; ++Expansions )
+	{
+		if( Search.IsEmpty() )
+			return EPathSearchStatus::Found;
+
+		const int32      CurrentNode       = Search.Pop();
+		const FIntVector CurrentCoordinate = Search.Coordinates[ CurrentNode ];
+		const float      Cost              = Search.Costs[ CurrentNode ] + 1;
+
+		const uint8 Edges = Reverse ? 0xFF : GetEdges( Query, CurrentCoordinate );
+		for( int32 Direction = 0; Direction < HexagonDirections.Num(); ++Direction )
+		{
+			if( ( Edges >> Direction & 1 ) == 0 )
+				continue;
+
+			const FIntVector NeighborCoordinate = Reverse ? CurrentCoordinate - HexagonDirections[ Direction ] : CurrentCoordinate + HexagonDirections[ Direction ];
+			if( !Filter( NeighborCoordinate ) )
+				continue;
+
+			const FWalkCell* NeighborCell = Query.FindWalkCell( NeighborCoordinate );
+			if( !NeighborCell || ( Reverse && ( NeighborCell->Edges >> Direction & 1 ) == 0 ) )
+				continue;
+
+			const int32 NeighborNode = Search.FindOrAdd( NeighborCoordinate );
+			if( Search.IsClosed( NeighborNode ) || Cost >= Search.Costs[ NeighborNode ] )
+				continue;
+
+			Search.Costs[ NeighborNode ]   = Cost;
+			Search.Parents[ NeighborNode ] = CurrentNode;
+			Search.Push( NeighborNode, Cost );
+		}
+	}
+
+	return Search.IsEmpty() ? EPathSearchStatus::Found : EPathSearchStatus::InProgress;
+}
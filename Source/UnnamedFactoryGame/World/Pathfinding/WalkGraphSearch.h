@@ -0,0 +1,59 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FWorldVoxelQuery;
+struct FPathSearch;
+
+enum class EPathSearchStatus : uint8
+{
+	InProgress,
+	Found,
+	NotFound,
+};
+
+/**
+ * Searches over the walk graphs of the loaded chunks, every step between neighbouring cells costs 1.
+ * Filter limits the cells a search may enter, such as the chunks a path segment is refined in.
+ */
+struct UNNAMEDFACTORYGAME_API FWalkGraphSearch
+{
+	using FFilter = TFunctionRef< bool( const FIntVector& ) >;
+
+	/** Lower bound of the steps between two voxels */
+	static float GetFutureCost( const FIntVector& From, const FIntVector& To );
+
+	/** Edges of the voxel, also for a start that lies outside the graph */
+	static uint8 GetEdges( FWorldVoxelQuery& Query, const FIntVector& VoxelCoordinate );
+
+	/** A* from Start to Target, OutPath holds both ends */
+	static bool FindPath( FPathSearch& Search, FWorldVoxelQuery& Query, const FIntVector& Start, const FIntVector& Target, FFilter Filter, TArray< FIntVector >& OutPath );
+
+	/** Starts an A* from Start to Target that StepPath advances */
+	static void BeginPath( FPathSearch& Search, const FIntVector& Start, const FIntVector& Target );
+
+	/**
+	 * Expands up to MaxExpansions more nodes of the search BeginPath started, OutPath holds both ends once it is found.
+	 * The walk graphs may change between two steps, cells that are gone by then are no longer entered.
+	 */
+	static EPathSearchStatus StepPath( FPathSearch&          Search,
+	                                   FWorldVoxelQuery&     Query,
+	                                   const FIntVector&     Target,
+	                                   FFilter               Filter,
+	                                   int32                 MaxExpansions,
+	                                   TArray< FIntVector >& OutPath );
+
+	/**
+	 * Visits every cell reachable from Start in order of cost, the costs stay readable through Search afterwards.
+	 * Reverse follows the edges backwards, giving the cost of reaching Start from every cell instead.
+	 */
+	static void Flood( FPathSearch& Search, FWorldVoxelQuery& Query, const FIntVector& Start, bool Reverse, FFilter Filter );
+
+	/** Starts a Flood from Start that StepFlood advances */
+	static void BeginFlood( FPathSearch& Search, const FIntVector& Start );
+
+	/** Visits up to MaxExpansions more cells of the flood BeginFlood started, Found once every reachable cell has been visited */
+	static EPathSearchStatus StepFlood( FPathSearch& Search, FWorldVoxelQuery& Query, bool Reverse, FFilter Filter, int32 MaxExpansions );
+};